@@ -3,5 +3,7 @@
 
 #cmakedefine PCRE2_FOUND
 #cmakedefine GIOMM_FOUND
-#cmakedefine GTKMM_FOUND
-#cmakedefine I3IPC_FOUND
\ No newline at end of file
+#cmakedefine DRUN_FOUND
+#cmakedefine RECENT_FOUND
+#cmakedefine I3IPC_FOUND
+#cmakedefine COPROCESS_FOUND
\ No newline at end of file
@@ -0,0 +1,594 @@
+#include <YaltlConfig.h>
+
+#include "yaltl.h"
+#include "modes/dmenu.h"
+#include "modes/run.h"
+#include "utils/charindex.h"
+#include "utils/command.h"
+#include "utils/frontcoded.h"
+#include "utils/histogram.h"
+#include "utils/json.h"
+#include "utils/matcher.h"
+#include "utils/regex.h"
+
+#include <chrono>
+#include <codecvt>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <getopt.h>
+#include <iostream>
+#include <limits>
+#include <locale>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Microbenchmarks for the matching and loading hot paths.
+ *
+ * Every corpus is generated from a fixed seed with its own generator, so two builds
+ * (i.e: PCRE2 and STL regex, or before and after a change) see exactly the same input.
+ * Results go to stdout as JSON, progress to stderr.
+ *
+ */
+namespace bench
+{
+    using Clock = std::chrono::steady_clock;
+
+    //! Larger corpora take minutes and gigabytes, so they have to be asked for
+    constexpr size_t DEFAULT_MAX_ENTRIES{1'000'000};
+
+    //! Creating more files than this for run's $PATH isn't worth it
+    constexpr size_t MAX_PATH_FILES{100'000};
+
+    constexpr size_t SIZES[]{1'000, 10'000, 100'000, 1'000'000, 10'000'000};
+
+    struct Options
+    {
+        size_t maxEntries{DEFAULT_MAX_ENTRIES};
+        std::chrono::milliseconds minTime{500};
+        uint64_t seed{0x79616c746cULL};
+        std::string filter;
+    };
+
+    /**
+     * @brief splitmix64, unlike std distributions it gives the same numbers on every standard library
+     *
+     */
+    class Random
+    {
+    public:
+        explicit Random(uint64_t seed) : m_state(seed)
+        {
+        }
+
+        uint64_t Next()
+        {
+            uint64_t z{m_state += 0x9e3779b97f4a7c15ULL};
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            return z ^ (z >> 31);
+        }
+
+        //! Uniform enough for picking words, [0, bound)
+        size_t Below(size_t bound)
+        {
+            return static_cast<size_t>(Next() % bound);
+        }
+
+        template <class Container>
+        const auto &Pick(const Container &items)
+        {
+            return items[Below(std::size(items))];
+        }
+
+    private:
+        uint64_t m_state;
+    };
+
+    namespace corpus
+    {
+        constexpr const wchar_t *SYLLABLES[]{L"gn", L"ome", L"ter", L"min", L"al", L"x", L"fire", L"fox", L"py", L"thon",
+                                             L"cl", L"ang", L"git", L"hub", L"sys", L"temd", L"ctl", L"net", L"work", L"man",
+                                             L"ager", L"edit", L"or", L"view", L"er", L"ls", L"blk", L"zip", L"gz", L"conv"};
+
+        constexpr const wchar_t *WORDS[]{L"projects", L"src", L"include", L"build", L"docs", L"images", L"music", L"config",
+                                         L"cache", L"share", L"local", L"notes", L"reports", L"invoices", L"photos", L"backup",
+                                         L"timeout", L"connection", L"request", L"handler", L"worker", L"session", L"client", L"server"};
+
+        constexpr const wchar_t *EXTENSIONS[]{L"cpp", L"h", L"md", L"txt", L"png", L"pdf", L"json", L"log", L"tar.gz"};
+
+        constexpr const wchar_t *LEVELS[]{L"DEBUG", L"INFO", L"INFO", L"INFO", L"WARN", L"ERROR"};
+
+        constexpr const wchar_t *UNICODE_WORDS[]{L"東京", L"大阪", L"日本語", L"音楽", L"Москва", L"привет", L"Ελλάδα", L"καλημέρα",
+                                                 L"café", L"naïve", L"über", L"smørrebrød", L"Ærø", L"北京", L"서울", L"한국어",
+                                                 L"🎵", L"🚀", L"mañana", L"Zürich", L"Kraków", L"İstanbul", L"ΣΟΦΙΑ", L"Ünïcödé"};
+
+        //! Binary names like the ones found on $PATH
+        std::wstring binary(Random &random)
+        {
+            std::wstring name;
+            for (size_t count{1 + random.Below(3)}; count > 0; --count)
+            {
+                name += random.Pick(SYLLABLES);
+                if (count > 1 && random.Below(3) == 0)
+                {
+                    name += L'-';
+                }
+            }
+
+            if (random.Below(4) == 0)
+            {
+                name += std::to_wstring(random.Below(20));
+            }
+
+            return name;
+        }
+
+        std::wstring path(Random &random)
+        {
+            std::wstring path{L"/home/user"};
+            for (size_t depth{1 + random.Below(5)}; depth > 0; --depth)
+            {
+                path += L'/';
+                path += random.Pick(WORDS);
+            }
+
+            // Drawn one at a time, the order operands are evaluated in isn't fixed
+            path += L'/' + binary(random);
+            path += L'.';
+            path += random.Pick(EXTENSIONS);
+
+            return path;
+        }
+
+        //! About 150 to 250 characters, like a service's log
+        std::wstring log(Random &random)
+        {
+            const size_t hours{random.Below(24)};
+            const size_t minutes{random.Below(60)};
+            const size_t seconds{random.Below(60)};
+            const size_t millis{random.Below(1000)};
+            wchar_t stamp[32]{};
+            swprintf(stamp, std::size(stamp), L"2026-10-19T%02zu:%02zu:%02zu.%03zuZ ", hours, minutes, seconds, millis);
+
+            std::wstring line{stamp};
+            line += random.Pick(LEVELS);
+            line += L" [";
+            line += random.Pick(WORDS);
+            line += L"] ";
+
+            const size_t length{150 + random.Below(100)};
+            while (line.size() < length)
+            {
+                line += random.Pick(WORDS);
+                line += random.Below(5) == 0 ? L"=" + std::to_wstring(random.Below(100000)) + L' ' : L" ";
+            }
+
+            return line;
+        }
+
+        std::wstring title(Random &random)
+        {
+            std::wstring title;
+            for (size_t words{2 + random.Below(4)}; words > 0; --words)
+            {
+                title += random.Pick(UNICODE_WORDS);
+                title += words > 1 ? L" " : L"";
+            }
+
+            return title;
+        }
+
+        //! Command lines with arguments and quoting for commands::parse
+        std::wstring commandline(Random &random)
+        {
+            std::wstring command{binary(random)};
+            for (size_t args{random.Below(4)}; args > 0; --args)
+            {
+                switch (random.Below(3))
+                {
+                case 0:
+                    command += L" --" + std::wstring{random.Pick(WORDS)};
+                    break;
+                case 1:
+                    command += L" \"";
+                    command += random.Pick(WORDS);
+                    command += L' ';
+                    command += random.Pick(WORDS);
+                    command += L'"';
+                    break;
+                default:
+                    command += L' ' + path(random);
+                    break;
+                }
+            }
+
+            return command;
+        }
+
+        struct Corpus
+        {
+            const char *name;
+            std::function<std::wstring(Random &)> generate;
+
+            //! What a user might type while looking for something in it
+            std::wstring query;
+        };
+
+        const std::vector<Corpus> &all()
+        {
+            static const std::vector<Corpus> corpora{
+                {"names", binary, L"gte"},
+                {"paths", path, L"srcedit"},
+                {"logs", log, L"errtimeout"},
+                {"unicode", title, L"café東"},
+            };
+
+            return corpora;
+        }
+
+        yaltl::Entries generate(const Corpus &corpus, size_t count, uint64_t seed)
+        {
+            Random random{seed};
+            yaltl::Entries entries;
+            entries.reserve(count);
+            for (size_t x{}; x < count; ++x)
+            {
+                entries.push_back(std::make_shared<yaltl::Entry>(corpus.generate(random)));
+            }
+
+            return entries;
+        }
+    } // namespace corpus
+
+    /**
+     * @brief Hands a fixed set of entries to Yaltl
+     *
+     */
+    class Fixed : public yaltl::Mode
+    {
+    public:
+        explicit Fixed(const yaltl::Entries &entries) : m_entries(entries)
+        {
+        }
+
+        std::wstring Name() const override
+        {
+            return L"bench";
+        }
+
+        const yaltl::Entries &Results() override
+        {
+            return m_entries;
+        }
+
+        yaltl::PostExec Execute(const yaltl::Entry &, const std::wstring &) override
+        {
+            return yaltl::PostExec::StayOpen;
+        }
+
+    private:
+        const yaltl::Entries &m_entries;
+    };
+
+    class Runner
+    {
+    public:
+        explicit Runner(const Options &options) : m_options(options)
+        {
+        }
+
+        /**
+         * @brief Times an operation until it has run long enough to trust
+         *
+         * @param name The benchmark
+         * @param corpus The corpus it ran against
+         * @param entries How many entries each run handles, to report per entry times
+         * @param operation The timed operation, returns false if it couldn't run
+         * @param reset Untimed work between runs
+         */
+        void Measure(const std::string &name, const std::string &corpus, size_t entries, const std::function<bool()> &operation, const std::function<void()> &reset = {})
+        {
+            const std::string id{name + "/" + corpus + "/" + std::to_string(entries)};
+            if (!m_options.filter.empty() && id.find(m_options.filter) == std::string::npos)
+            {
+                return;
+            }
+
+            std::cerr << id << std::flush;
+
+            // Warm up caches and allocators once before timing
+            if (reset)
+            {
+                reset();
+            }
+
+            if (!operation())
+            {
+                std::cerr << " skipped" << std::endl;
+                return;
+            }
+
+            yaltl::Histogram histogram;
+            Clock::duration total{};
+            while (histogram.Count() < 3 || (total < m_options.minTime && histogram.Count() < 10'000))
+            {
+                if (reset)
+                {
+                    reset();
+                }
+
+                const Clock::time_point begin{Clock::now()};
+                operation();
+                const Clock::duration spent{Clock::now() - begin};
+
+                total += spent;
+                histogram.Record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(spent).count()));
+            }
+
+            std::cerr << " " << histogram.Percentile(50) / 1e6 << "ms" << std::endl;
+
+            m_results += (m_results.empty() ? "\n" : ",\n");
+            m_results += "{\"name\":" + yaltl::json::quote(name) +
+                         ",\"corpus\":" + yaltl::json::quote(corpus) +
+                         ",\"entries\":" + std::to_string(entries) +
+                         ",\"median_ns_per_entry\":" + std::to_string(entries ? static_cast<double>(histogram.Percentile(50)) / entries : 0) +
+                         ",\"histogram\":" + histogram.Json() + "}";
+        }
+
+        void Write(std::ostream &out) const
+        {
+#ifdef PCRE2_FOUND
+            constexpr auto BACKEND = "pcre2";
+#else
+            constexpr auto BACKEND = "stl";
+#endif
+
+            out << "{\"version\":\"" << YALTL_VERSION_MAJOR << "." << YALTL_VERSION_MINOR
+                << "\",\"regex\":\"" << BACKEND
+                << "\",\"seed\":" << m_options.seed
+                << ",\"unit\":\"ns\",\"results\":[" << m_results << "\n]}" << std::endl;
+        }
+
+    private:
+        const Options &m_options;
+        std::string m_results;
+    };
+
+    void matching(Runner &runner, const Options &options)
+    {
+        std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+        for (const corpus::Corpus &corpus : corpus::all())
+        {
+            runner.Measure("build_regex", corpus.name, 1, [&corpus] {
+                yaltl::regex::regex_t regex{yaltl::regex::build_regex(corpus.query)};
+                return true;
+            });
+
+            for (size_t size : SIZES)
+            {
+                if (size > options.maxEntries)
+                {
+                    break;
+                }
+
+                const yaltl::Entries entries{corpus::generate(corpus, size, options.seed)};
+
+                const yaltl::regex::regex_t regex{yaltl::regex::build_regex(corpus.query)};
+                runner.Measure("fuzzy_find", corpus.name, size, [&entries, &regex] {
+                    size_t matches{};
+                    for (const auto &entry : entries)
+                    {
+                        matches += yaltl::regex::fuzzy_find(entry->display, regex).has_value();
+                    }
+
+                    return matches <= entries.size();
+                });
+
+                // What dmenu's index costs to build and how far it narrows the query down, with its size on stderr
+                std::optional<yaltl::CharIndex> index;
+                runner.Measure("index_build", corpus.name, size, [&entries, &index] {
+                    index = yaltl::CharIndex::build(entries, std::numeric_limits<size_t>::max(), {});
+                    return index.has_value();
+                });
+
+                if (index.has_value())
+                {
+                    const std::optional<std::vector<uint32_t>> candidates{index->Candidates(corpus.query)};
+                    std::cerr << "index/" << corpus.name << "/" << size << " " << index->Bytes() << " bytes, "
+                              << (candidates.has_value() ? std::to_string(candidates->size()) : std::string{"all"}) << " candidates" << std::endl;
+
+                    runner.Measure("index_candidates", corpus.name, size, [&index, &corpus] {
+                        return index->Candidates(corpus.query).has_value();
+                    });
+                }
+
+                // The same entries kept compact the way dmenu --compact does, with its size on stderr
+                yaltl::FrontCoded store;
+                for (const auto &entry : entries)
+                {
+                    store.Append(converter.to_bytes(entry->display));
+                }
+
+                store.Shrink();
+                std::cerr << "store/" << corpus.name << "/" << size << " " << store.Bytes() << " bytes" << std::endl;
+                runner.Measure("rank_store", corpus.name, size, [&store, &corpus] {
+                    size_t exact{};
+                    return yaltl::matcher::rank(store, std::nullopt, corpus.query, false, 10'000, exact).size() <= store.Size();
+                });
+
+                // The whole keystroke: the search changes, then the next update ranks everything
+                yaltl::Modes modes;
+                modes.emplace_back(std::make_unique<Fixed>(entries));
+                yaltl::Yaltl yaltl{std::move(modes), [] {}};
+                for (wchar_t ch : corpus.query)
+                {
+                    yaltl.OnEvent(ftxui::Event::Character(ch));
+                }
+
+                const wchar_t last{corpus.query.back()};
+                runner.Measure(
+                    "update_entries", corpus.name, size, [&yaltl, last] {
+                        yaltl.OnEvent(ftxui::Event::Character(last));
+                        yaltl.OnEvent(ftxui::Event::Custom);
+                        return true;
+                    },
+                    [&yaltl] { yaltl.OnEvent(ftxui::Event::Backspace); });
+            }
+        }
+    }
+
+    void loading(Runner &runner, const Options &options)
+    {
+        std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+        const std::filesystem::path scratch{std::filesystem::temp_directory_path() / ("yaltl_bench." + std::to_string(options.seed))};
+        std::filesystem::create_directories(scratch);
+
+        for (size_t size : SIZES)
+        {
+            if (size > options.maxEntries)
+            {
+                break;
+            }
+
+            // dmenu reads whatever is piped in
+            for (const corpus::Corpus &corpus : corpus::all())
+            {
+                const std::filesystem::path input{scratch / corpus.name};
+                {
+                    Random random{options.seed};
+                    std::ofstream out{input, std::ios::binary};
+                    for (size_t x{}; x < size; ++x)
+                    {
+                        out << converter.to_bytes(corpus.generate(random)) << '\n';
+                    }
+                }
+
+                runner.Measure(
+                    "load_stdin", corpus.name, size, [] { return !yaltl::modes::load_stdin().empty(); },
+                    [&input] { std::freopen(input.string().c_str(), "r", stdin); });
+                runner.Measure(
+                    "load_stdin_store", corpus.name, size, [] { return yaltl::modes::load_stdin_store().Size() > 0; },
+                    [&input] { std::freopen(input.string().c_str(), "r", stdin); });
+                std::filesystem::remove(input);
+            }
+
+            {
+                Random random{options.seed};
+                std::vector<std::string> commandlines;
+                commandlines.reserve(size);
+                for (size_t x{}; x < size; ++x)
+                {
+                    commandlines.push_back(converter.to_bytes(corpus::commandline(random)));
+                }
+
+                runner.Measure("commands_parse", "commandlines", size, [&commandlines] {
+                    size_t args{};
+                    for (const std::string &commandline : commandlines)
+                    {
+                        args += yaltl::commands::parse(commandline).argv.size();
+                    }
+
+                    return args > 0;
+                });
+            }
+
+            // run lists every file on $PATH
+            if (size <= MAX_PATH_FILES)
+            {
+                const std::filesystem::path bin{scratch / ("bin" + std::to_string(size))};
+                std::filesystem::create_directories(bin);
+                Random random{options.seed};
+                for (size_t x{}; x < size; ++x)
+                {
+                    std::ofstream{bin / (converter.to_bytes(corpus::binary(random)) + std::to_string(x))};
+                }
+
+                const std::string path{bin.string()};
+                runner.Measure("run_load", "names", size, [&path] {
+#ifdef WIN32
+                    _putenv_s("PATH", path.c_str());
+#else
+                    setenv("PATH", path.c_str(), 1);
+#endif
+                    yaltl::Batches batches;
+                    yaltl::modes::load(batches, [] {});
+
+                    yaltl::Entries binaries;
+                    batches.Drain(binaries);
+                    return !binaries.empty();
+                });
+
+                std::filesystem::remove_all(bin);
+            }
+        }
+
+        std::filesystem::remove_all(scratch);
+    }
+
+    void help()
+    {
+        std::cerr << "yaltl_bench usage:" << std::endl
+                  << "\tyaltl_bench [--options] > results.json" << std::endl
+                  << "Options:" << std::endl
+                  << "\t-n, --max N\tLargest corpus to generate, up to 10000000 [" << DEFAULT_MAX_ENTRIES << "]" << std::endl
+                  << "\t-t, --time MS\tKeep repeating each benchmark for at least this long [500]" << std::endl
+                  << "\t-s, --seed N\tSeed for the corpora" << std::endl
+                  << "\t-f, --filter TEXT\tOnly run benchmarks with TEXT in name/corpus/entries" << std::endl
+                  << "\t-h, --help \tDisplay this message" << std::endl;
+
+        exit(-1);
+    }
+
+    Options parse_args(int argc, char **argv)
+    {
+        Options options;
+        static option longOptions[] = {
+            {"max", required_argument, nullptr, 'n'},
+            {"time", required_argument, nullptr, 't'},
+            {"seed", required_argument, nullptr, 's'},
+            {"filter", required_argument, nullptr, 'f'},
+            {"help", no_argument, nullptr, 'h'},
+            {nullptr, 0, nullptr, 0},
+        };
+
+        for (int code{getopt_long(argc, argv, "n:t:s:f:h", longOptions, nullptr)}; code >= 0; code = getopt_long(argc, argv, "n:t:s:f:h", longOptions, nullptr))
+        {
+            switch (code)
+            {
+            case 'n':
+                options.maxEntries = std::strtoull(optarg, nullptr, 10);
+                break;
+            case 't':
+                options.minTime = std::chrono::milliseconds{std::strtoull(optarg, nullptr, 10)};
+                break;
+            case 's':
+                options.seed = std::strtoull(optarg, nullptr, 0);
+                break;
+            case 'f':
+                options.filter = optarg;
+                break;
+            default:
+                help();
+            }
+        }
+
+        return options;
+    }
+} // namespace bench
+
+int main(int argc, char **argv)
+{
+    const bench::Options options{bench::parse_args(argc, argv)};
+
+    bench::Runner runner{options};
+    bench::matching(runner, options);
+    bench::loading(runner, options);
+    runner.Write(std::cout);
+
+    return 0;
+}
@@ -1,12 +1,20 @@
 #pragma once
 
+#include <ftxui/dom/elements.hpp>
+
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <stop_token>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace yaltl
 {
+    class FrontCoded;
+
     struct Entry
     {
         explicit Entry(std::wstring &&disp) : display(std::move(disp))
@@ -51,25 +59,120 @@ namespace yaltl
         virtual std::wstring Name() const = 0;
 
         /**
-         * @brief Gets the results to display
+         * @brief Gets the results loaded so far, must not block waiting on loading to finish
          * 
          * @return Entries The results for the input box
          */
         virtual const Entries &Results() = 0;
 
         /**
-         * @brief Asks the mode to preview the selected result
+         * @brief Checks if the mode is still loading results in the background
+         * 
+         * @return true - More results may show up, Notify will be called when they do
+         */
+        virtual bool Loading() const
+        {
+            return false;
+        }
+
+        /**
+         * @brief Changes whenever results were replaced or removed instead of only appended to.
+         * 
+         * @return size_t The generation, when it changes all results need to be searched again
+         */
+        virtual size_t Generation() const
+        {
+            return 0;
+        }
+
+        /**
+         * @brief Sets the callback for when new results are ready to be picked up through Results
+         * 
+         * @param callback Called from any thread
+         */
+        void Subscribe(std::function<void()> callback)
+        {
+            std::scoped_lock lock{m_subscriberLock};
+            m_subscriber = std::move(callback);
+        }
+
+        /**
+         * @brief Checks if the mode has previews, yaltl only makes room for a preview pane when it does
+         * 
+         * @return true - Preview should be called for the selected result
+         */
+        virtual bool HasPreview() const
+        {
+            return false;
+        }
+
+        /**
+         * @brief Builds a preview of the selected result, called on a background thread
          * 
          * @param selected The selected result to preview
-         * @return The preview action to wait on if any
+         * @param stop Requested when the selection moved on, slow previews should give up when it is
+         * @return ftxui::Element The preview to show next to the results, nullptr if there is none for now, which is asked for again the next time it's selected
          */
-        virtual void Preview(const Entry &){};
+        virtual ftxui::Element Preview(const Entry &selected, std::stop_token stop)
+        {
+            return nullptr;
+        }
+
+        /**
+         * @brief Lets the mode know the search text changed, for modes that look for results themselves
+         * 
+         * @param text The text box contents
+         */
+        virtual void Search(const std::wstring &text)
+        {
+        }
 
         virtual bool FirstWordOnly() const
         {
             return false;
         }
 
+        /**
+         * @brief Narrows down which results may match a search, for modes with too many to scan on every key (any thread)
+         * 
+         * @param search The text matched, i.e: the first word for FirstWordOnly modes
+         * @return std::optional<std::vector<uint32_t>> Indexes into Results of every result that may match in order, nullopt to scan them all
+         */
+        virtual std::optional<std::vector<uint32_t>> Candidates(std::wstring_view search) const
+        {
+            return std::nullopt;
+        }
+
+        /**
+         * @brief Gets the mode's results stored compactly, for inputs too large to keep as entries
+         * 
+         * @return const FrontCoded* The results, searched instead of Results and only made entries once they match, nullptr to search Results
+         */
+        virtual const FrontCoded *Store() const
+        {
+            return nullptr;
+        }
+
+        /**
+         * @brief Gets the modes this one combines, each is searched on its own and its results are executed by it
+         * 
+         * @return std::vector<Mode *> The modes, empty for modes with results of their own
+         */
+        virtual std::vector<Mode *> Parts()
+        {
+            return {};
+        }
+
+        /**
+         * @brief Checks if the mode finished what Execute started, after Execute returned PostExec::StayOpen
+         * 
+         * @return std::optional<PostExec> How to close, nullopt to stay open
+         */
+        virtual std::optional<PostExec> Finished()
+        {
+            return std::nullopt;
+        }
+
         /**
          * @brief Asks the mode to execute the selected result
          * 
@@ -78,6 +181,21 @@ namespace yaltl
          * @return The result of the execution
          */
         virtual PostExec Execute(const Entry &result, const std::wstring &text) = 0;
+
+    protected:
+        //! Lets the subscriber know new results are ready, safe to call from any thread
+        void Notify()
+        {
+            std::scoped_lock lock{m_subscriberLock};
+            if (m_subscriber)
+            {
+                m_subscriber();
+            }
+        }
+
+    private:
+        std::mutex m_subscriberLock;
+        std::function<void()> m_subscriber;
     };
 
     using Modes = std::vector<std::unique_ptr<Mode>>;
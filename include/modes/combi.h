@@ -0,0 +1,60 @@
+#pragma once
+
+#include "../mode.h"
+
+#include <vector>
+
+namespace yaltl
+{
+    namespace modes
+    {
+        /**
+         * @brief Searches every other mode at once, like rofi's combi, each result is executed by the mode it came from.
+         * 
+         */
+        class combi : public Mode
+        {
+        public:
+            /**
+             * @brief Construct a new combi object
+             * 
+             * @param modes The modes to combine, must outlive the combi
+             */
+            explicit combi(std::vector<Mode *> modes);
+
+            std::wstring Name() const override
+            {
+                return L"combi";
+            }
+
+            //! The results all come from the parts
+            const Entries &Results() override
+            {
+                return m_none;
+            }
+
+            bool Loading() const override;
+
+            bool HasPreview() const override;
+
+            void Search(const std::wstring &text) override;
+
+            std::optional<PostExec> Finished() override;
+
+            std::vector<Mode *> Parts() override
+            {
+                return m_modes;
+            }
+
+            //! Never called, the results are executed by the parts
+            PostExec Execute(const Entry &result, const std::wstring &text) override
+            {
+                return PostExec::StayOpen;
+            }
+
+        private:
+            std::vector<Mode *> m_modes;
+            Entries m_none;
+        };
+    } // namespace modes
+} // namespace yaltl
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "../mode.h"
+#include "utils/batches.h"
+
+#include <atomic>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <sys/types.h>
+
+namespace yaltl
+{
+    namespace modes
+    {
+        /**
+         * @brief Starts a script once and talks to it over its stdin and stdout with newline delimited JSON.
+         *
+         * yaltl writes {"event":"query","text":"..."} when the search changes and
+         * {"event":"select","text":"...","query":"..."} when a result is picked.
+         * The script writes {"replace":["..."]} or {"append":["..."]} to change the results,
+         * and {"close":true} to close yaltl.
+         */
+        class coprocess : public Mode
+        {
+        public:
+            coprocess(std::string_view name, std::string_view command);
+            ~coprocess() override;
+
+            std::wstring Name() const override
+            {
+                return m_name;
+            }
+
+            const Entries &Results() override;
+
+            bool Loading() const override
+            {
+                return m_waiting;
+            }
+
+            size_t Generation() const override
+            {
+                return m_batches.Generation();
+            }
+
+            void Search(const std::wstring &text) override;
+
+            std::optional<PostExec> Finished() override;
+
+            PostExec Execute(const Entry &result, const std::wstring &text) override;
+
+        private:
+            /**
+             * @brief Reads messages from the script until it exits (reader thread)
+             *
+             * @param stop Asks the thread to stop
+             */
+            void Read(std::stop_token stop);
+
+            /**
+             * @brief Applies a message from the script (reader thread)
+             *
+             * @param line One line of output, lines that aren't messages are ignored
+             */
+            void Handle(std::string_view line);
+
+            /**
+             * @brief Queues a message for the script, writing as much of it as the socket takes right away
+             *
+             * @param message The JSON message without the newline
+             * @return true - The message was queued, the reader thread writes the rest once the script reads
+             * @return false - The script exited, or stopped reading and the queue is full
+             */
+            bool Send(std::string message);
+
+            /**
+             * @brief Writes queued messages until the socket is full, m_outboxLock must be held
+             *
+             * @return true - The script is still there
+             */
+            bool Flush();
+
+        private:
+            std::wstring m_name;
+            pid_t m_pid{-1};
+
+            //! Our end of the socket pair that is the script's stdin and stdout
+            int m_socket{-1};
+
+            Entries m_results;
+            Batches m_batches;
+
+            //! Messages not written yet, only ever whole lines so the script never sees part of one
+            std::mutex m_outboxLock;
+            std::string m_outbox;
+
+            //! Set while waiting on the script to answer
+            std::atomic<bool> m_waiting{true};
+
+            //! Set when the script asked to close
+            std::atomic<bool> m_close{};
+
+            //! Set once the script's output closed
+            std::atomic<bool> m_exited{};
+
+            //! Set once a result was sent to the script
+            bool m_executed{};
+
+            //! Declared last so the thread stops before the rest is destroyed
+            std::jthread m_reader;
+        };
+    } // namespace modes
+} // namespace yaltl
@@ -1,7 +1,12 @@
 #pragma once
 
 #include "../mode.h"
-#include "utils/popen.h"
+#include "utils/charindex.h"
+#include "utils/executor.h"
+#include "utils/file.h"
+#include "utils/frontcoded.h"
+
+#include <mutex>
 
 #define YALTL_HAS_DMENU
 
@@ -9,6 +14,20 @@ namespace yaltl
 {
     namespace modes
     {
+        /**
+         * @brief Loads all lines from stdin
+         * 
+         * @return Entries The lines read from stdin
+         */
+        Entries load_stdin();
+
+        /**
+         * @brief Loads all lines from stdin into a compact store, a chunk at a time rather than all at once
+         * 
+         * @return FrontCoded The lines read from stdin
+         */
+        FrontCoded load_stdin_store();
+
         /**
          * @brief Takes input from stdin, enables user to search and select for selection to be printed on stdout
          * 
@@ -16,7 +35,12 @@ namespace yaltl
         class dmenu : public Mode
         {
         public:
-            dmenu();
+            /**
+             * @brief Reads stdin and takes over the tty
+             * 
+             * @param compact Keep the lines in a compact store instead of as entries, for inputs of millions of lines
+             */
+            explicit dmenu(bool compact = false);
             ~dmenu();
 
             std::wstring
@@ -30,6 +54,15 @@ namespace yaltl
                 return m_entries;
             }
 
+            //! The lines when they're kept compact
+            const FrontCoded *Store() const override
+            {
+                return m_compact ? &m_store : nullptr;
+            }
+
+            //! Uses the index once it's built, large inputs only
+            std::optional<std::vector<uint32_t>> Candidates(std::wstring_view search) const override;
+
             PostExec Execute(const Entry &result, const std::wstring &text) override;
 
         private:
@@ -37,9 +70,15 @@ namespace yaltl
             /// WARNING, order here matters, DO NOT RE-ORDER
             ///
 
+            //! Whether stdin is kept in m_store instead of m_entries
+            const bool m_compact;
+
             //! The lines read from stdin
             const Entries m_entries;
 
+            //! The lines read from stdin when compact
+            const FrontCoded m_store;
+
             //! The file descriptor to "stdout"
             int m_stdoutCopy{};
 
@@ -51,6 +90,13 @@ namespace yaltl
 
             //! The file handle to tty-out
             unique_file m_ttyOut;
+
+            //! Guards m_index, which is built on a worker
+            mutable std::mutex m_indexLock;
+            std::shared_ptr<const CharIndex> m_index;
+
+            //! Declared last so indexing stops before the rest is destroyed
+            executor::Job m_indexing;
         };
     } // namespace modes
 
@@ -1,7 +1,8 @@
 #pragma once
 
 #include "../mode.h"
-#include <future>
+#include "utils/batches.h"
+#include "utils/executor.h"
 
 namespace yaltl
 {
@@ -25,11 +26,19 @@ namespace yaltl
 
             const Entries &Results() override;
 
+            bool Loading() const override
+            {
+                return !m_batches.Done();
+            }
+
             PostExec Execute(const Entry &result, const std::wstring &text) override;
 
         private:
             Entries m_entries;
-            std::future<Entries> m_loading;
+            Batches m_batches;
+
+            //! Declared last so loading finishes before the rest is destroyed
+            executor::Job m_loading;
         };
     } //namespace modes
 } // namespace yaltl
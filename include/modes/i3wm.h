@@ -2,21 +2,36 @@
 
 #include "../mode.h"
 
-#include <i3ipc++/ipc.hpp>
+#include "utils/i3ipc.h"
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 namespace yaltl
 {
     namespace modes
     {
         /**
-         * @brief Uses i3ipc to switch between active windows in swaywm/i3wm.
+         * @brief Uses the i3 IPC protocol to switch between active windows in swaywm/i3wm.
          * 
          */
         class i3wm : public Mode
         {
-            using con_t = std::shared_ptr<i3ipc::container_t>;
-
         public:
+            //! The parts of a container that matter for switching windows
+            struct Window
+            {
+                uint64_t id{};
+                std::string name;
+
+                //! app_id on sway, the X11 instance otherwise
+                std::string app_id;
+            };
+
             i3wm(std::string &&self_id);
 
             std::wstring Name() const override
@@ -26,15 +41,68 @@ namespace yaltl
 
             const Entries &Results() override;
 
-            void Preview(const Entry &selected) override;
+            bool Loading() const override
+            {
+                return !m_loaded;
+            }
+
+            size_t Generation() const override
+            {
+                return m_generation;
+            }
 
             PostExec Execute(const Entry &result, const std::wstring &) override;
 
         private:
-            i3ipc::connection m_conn;
+            /**
+             * @brief Gets the windows once, then keeps them up to date from window and workspace events
+             * 
+             * @param stop Asks the thread to stop
+             */
+            void WatchEvents(std::stop_token stop);
+
+        private:
+            i3::Connection m_conn;
             Entries m_active;
             std::string m_self_id;
+            size_t m_generation{};
+
+            //! The windows as of the latest event, shared with the event thread
+            std::vector<Window> m_windows;
+            std::mutex m_windowsLock;
+
+            //! Set when m_windows changed since the last call to Results
+            bool m_dirty{};
+            std::atomic<bool> m_loaded{};
+
+            //! Declared last so the event thread stops before the rest is destroyed
+            std::jthread m_watcher;
         };
+
+        //! Reads the windows out of i3 and sway trees, in a single pass over the JSON
+        namespace tree
+        {
+            /**
+             * @brief Get all the windows in the tree
+             * 
+             * @param tree The GET_TREE reply
+             * @param self Identifier for self to avoid
+             * @return std::vector<i3wm::Window> The windows in tree order, floating ones included
+             */
+            std::vector<i3wm::Window> windows(std::string_view tree, const std::string &self);
+
+            /**
+             * @brief Reads a window event, i.e: {"change":"new","container":{...}}
+             * 
+             * @param payload The event payload
+             * @param self Identifier for self to avoid
+             * @param change [Out] What happened to the window
+             * @param con [Out] The window
+             * @param isWindow [Out] If the container is a window we should list
+             * @return true - The event was read
+             */
+            bool window_event(std::string_view payload, const std::string &self, std::string &change, i3wm::Window &con, bool &isWindow);
+        } // namespace tree
     } // namespace modes
 
 } // namespace yaltl
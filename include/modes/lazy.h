@@ -0,0 +1,117 @@
+#pragma once
+
+#include "../mode.h"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stop_token>
+#include <vector>
+
+namespace yaltl
+{
+    namespace modes
+    {
+        /**
+         * @brief Stands in for a mode until something needs it, so modes that aren't shown first don't slow down the first frame.
+         * 
+         */
+        class lazy : public Mode
+        {
+        public:
+            using Factory = std::function<std::unique_ptr<Mode>()>;
+
+            /**
+             * @brief Construct a new lazy object
+             * 
+             * @param factory Builds the mode, called once from whichever thread needs it first, must not return nullptr
+             */
+            explicit lazy(Factory factory);
+
+            /**
+             * @brief Gets the mode, building it if it hasn't been yet (any thread)
+             * 
+             * @return Mode& The mode
+             */
+            Mode &Get() const;
+
+            std::wstring Name() const override
+            {
+                return Get().Name();
+            }
+
+            const Entries &Results() override
+            {
+                return Get().Results();
+            }
+
+            bool Loading() const override
+            {
+                return Get().Loading();
+            }
+
+            size_t Generation() const override
+            {
+                return Get().Generation();
+            }
+
+            bool HasPreview() const override
+            {
+                return Get().HasPreview();
+            }
+
+            ftxui::Element Preview(const Entry &selected, std::stop_token stop) override
+            {
+                return Get().Preview(selected, stop);
+            }
+
+            void Search(const std::wstring &text) override
+            {
+                Get().Search(text);
+            }
+
+            bool FirstWordOnly() const override
+            {
+                return Get().FirstWordOnly();
+            }
+
+            std::optional<std::vector<uint32_t>> Candidates(std::wstring_view search) const override
+            {
+                return Get().Candidates(search);
+            }
+
+            const FrontCoded *Store() const override
+            {
+                return Get().Store();
+            }
+
+            std::vector<Mode *> Parts() override
+            {
+                return Get().Parts();
+            }
+
+            std::optional<PostExec> Finished() override
+            {
+                return Get().Finished();
+            }
+
+            PostExec Execute(const Entry &result, const std::wstring &text) override
+            {
+                return Get().Execute(result, text);
+            }
+
+        private:
+            Factory m_factory;
+            mutable std::once_flag m_built;
+            mutable std::unique_ptr<Mode> m_mode;
+        };
+
+        /**
+         * @brief Builds the modes that are still waiting, one at a time on the calling thread
+         * 
+         * @param modes The modes to build
+         * @param stop Stops before building the next mode
+         */
+        void prepare(const std::vector<lazy *> &modes, std::stop_token stop);
+    } // namespace modes
+} // namespace yaltl
@@ -1,13 +1,20 @@
 #pragma once
 
 #include "../mode.h"
+#include "utils/batches.h"
+#include "utils/executor.h"
+#include "utils/lru.h"
 
-#include <future>
+#include <mutex>
 
 namespace yaltl
 {
 	namespace modes
 	{
+		/**
+		 * @brief Lists recently used files from recently-used.xbel to open with xdg-open
+		 * 
+		 */
 		class recent : public Mode
 		{
 		public:
@@ -20,11 +27,35 @@ namespace yaltl
 
 			const Entries &Results() override;
 
+			bool Loading() const override
+			{
+				return !m_batches.Done();
+			}
+
+			size_t Generation() const override
+			{
+				return m_batches.Generation();
+			}
+
+			bool HasPreview() const override
+			{
+				return true;
+			}
+
+			ftxui::Element Preview(const Entry &selected, std::stop_token stop) override;
+
 			PostExec Execute(const Entry &result, const std::wstring &text) override;
 
 		private:
 			Entries m_entries;
-			std::future<Entries> m_loading;
+			Batches m_batches;
+
+			//! Rendered previews keyed by path and modification time
+			Lru<std::string, ftxui::Element> m_previews;
+			std::mutex m_previewsLock;
+
+			//! Declared last so loading finishes before the rest is destroyed
+			executor::Job m_loading;
 		};
 	} // namespace modes
 } // namespace yaltl
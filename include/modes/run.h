@@ -1,8 +1,9 @@
 #pragma once
 
 #include "../mode.h"
+#include "utils/batches.h"
+#include "utils/executor.h"
 
-#include <future>
 #include <optional>
 #include <vector>
 #include <filesystem>
@@ -11,6 +12,15 @@ namespace yaltl
 {
     namespace modes
     {
+        /**
+         * @brief Gets all the binaries from $PATH, one batch per directory
+         * 
+         * @param batches Where to put the binaries as they are found
+         * @param notify Called after each batch
+         * @param stop Stops before the next directory, the batches are still finished
+         */
+        void load(Batches &batches, const std::function<void()> &notify, std::stop_token stop = {});
+
         /**
          * @brief Finds binaries on path for user to search through and launch possibly with parameters.
          * 
@@ -27,6 +37,11 @@ namespace yaltl
 
             const Entries &Results() override;
 
+            bool Loading() const override
+            {
+                return !m_batches.Done();
+            }
+
             bool FirstWordOnly() const override
             {
                 return true;
@@ -35,8 +50,11 @@ namespace yaltl
             PostExec Execute(const Entry &result, const std::wstring &text) override;
 
         private:
-            std::future<Entries> m_loader;
             Entries m_binaries;
+            Batches m_batches;
+
+            //! Declared last so loading finishes before the rest is destroyed
+            executor::Job m_loader;
         };
     } // namespace modes
 
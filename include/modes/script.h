@@ -1,10 +1,14 @@
 #pragma once
 
 #include "../mode.h"
+#include "utils/batches.h"
 
-#include <future>
+#include <chrono>
+#include <optional>
+#include <stop_token>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <vector>
 
 namespace yaltl
@@ -14,11 +18,13 @@ namespace yaltl
         /**
          * @brief Loads a script and will recall script with selected output until no output is returned.
          * 
+         * With a ttl, the script's first output is cached and shown right away on the next launch,
+         * the script only runs again in the background once the cache is older than the ttl.
          */
         class script : public Mode
         {
         public:
-            script(std::string_view name, std::string_view script);
+            script(std::string_view name, std::string_view script, std::optional<std::chrono::seconds> ttl = std::nullopt);
 
             std::wstring Name() const override
             {
@@ -27,13 +33,40 @@ namespace yaltl
 
             const Entries &Results() override;
 
+            bool Loading() const override
+            {
+                return !m_batches.Done();
+            }
+
+            size_t Generation() const override
+            {
+                return m_batches.Generation();
+            }
+
+            std::optional<PostExec> Finished() override;
+
             PostExec Execute(const Entry &result, const std::wstring &) override;
 
+        private:
+            /**
+             * @brief Runs the command on a worker, adding its output to the results as it prints it
+             * 
+             * @param command The command to run
+             * @param ttl Cache the output for this long, nullopt to not cache it
+             */
+            void Start(std::string command, std::optional<std::chrono::seconds> ttl);
+
         private:
             std::wstring m_name;
             std::string m_script;
-            std::future<Entries> m_loader;
             Entries m_results;
+            Batches m_batches;
+
+            //! Set once Execute ran the script with a result
+            bool m_executed{};
+
+            //! Declared last so the script is killed before the rest is destroyed
+            std::jthread m_worker;
         };
     } // namespace modes
 } // namespace yaltl
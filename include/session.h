@@ -0,0 +1,74 @@
+#pragma once
+
+#include "yaltl.h"
+#include "utils/file.h"
+
+#include <chrono>
+#include <ostream>
+#include <string>
+
+namespace yaltl
+{
+    /**
+     * @brief Recording a session's keystrokes and replaying them headless, to measure latency end to end.
+     *
+     * Sessions are newline delimited JSON, one object per line:
+     *  {"session":1,"width":80,"height":24}  the terminal it was recorded in, always first
+     *  {"t":1200,"char":"f"}                 a typed character, t is microseconds since the start
+     *  {"t":1900,"special":"\u001b[B"}       any other key, as the terminal sent it
+     *  {"t":1900,"mode":"run"}               the mode after a key switched it
+     *  {"t":2500,"execute":"firefox","query":"fi"}  what was executed
+     *
+     */
+    namespace session
+    {
+        /**
+         * @brief Passes everything through to yaltl, writing down the keys and what they did
+         *
+         */
+        class Recorder : public ftxui::Component
+        {
+        public:
+            /**
+             * @brief Construct a new Recorder object
+             *
+             * @param yaltl What's being recorded, must outlive the recorder
+             * @param file Where to write the session
+             */
+            Recorder(Yaltl &yaltl, const std::string &file);
+
+            //! If the file could be opened
+            bool Recording() const
+            {
+                return static_cast<bool>(m_out);
+            }
+
+            bool OnEvent(ftxui::Event event) override;
+            ftxui::Element Render() override;
+
+        private:
+            //! Microseconds since recording started
+            uint64_t Now() const;
+
+        private:
+            Yaltl &m_yaltl;
+            unique_file m_out;
+            std::chrono::steady_clock::time_point m_start;
+            std::wstring m_mode;
+        };
+
+        /**
+         * @brief Replays a recorded session against a virtual terminal, without waiting between keys
+         *
+         * Each mode is given time to finish loading before keys go to it, and each key's search is waited for until every
+         * source is ranked, so runs see the same results.
+         * Executing is never replayed, the selection is compared with what was executed instead.
+         *
+         * @param yaltl What to replay against, with the same modes it was recorded with
+         * @param file The recorded session
+         * @param report Where the per key latencies and results are written as JSON
+         * @return int 0 if the replay ended up where the recording did, 1 if not, -1 if the file couldn't be read
+         */
+        int replay(Yaltl &yaltl, const std::string &file, std::ostream &report);
+    } // namespace session
+} // namespace yaltl
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "mode.h"
+
+#include <algorithm>
+#include <iterator>
+#include <mutex>
+#include <unordered_set>
+
+namespace yaltl
+{
+    /**
+     * @brief Hands entries loaded on a background thread over to the UI thread in batches.
+     * 
+     */
+    class Batches
+    {
+    public:
+        /**
+         * @brief Queues entries to be appended to the results (background thread)
+         * 
+         * @param batch The entries that finished loading
+         */
+        void Append(Entries &&batch)
+        {
+            std::scoped_lock lock{m_lock};
+            m_pending.insert(std::end(m_pending), std::make_move_iterator(std::begin(batch)), std::make_move_iterator(std::end(batch)));
+        }
+
+        /**
+         * @brief Queues entries to be removed from the results (background thread)
+         * 
+         * @param stale The entries to remove, they may still be waiting to be appended
+         */
+        void Remove(const Entries &stale)
+        {
+            std::scoped_lock lock{m_lock};
+            std::transform(std::begin(stale), std::end(stale), std::inserter(m_stale, std::end(m_stale)), [](const std::shared_ptr<Entry> &entry) {
+                return entry.get();
+            });
+        }
+
+        /**
+         * @brief Marks loading as done, no more batches will come (background thread)
+         * 
+         */
+        void Finish()
+        {
+            std::scoped_lock lock{m_lock};
+            m_done = true;
+        }
+
+        /**
+         * @brief Drops anything queued and has the next Drain clear the results, for loading them over again
+         * 
+         * Whatever was loading the old results must have stopped first.
+         */
+        void Restart()
+        {
+            std::scoped_lock lock{m_lock};
+            m_pending.clear();
+            m_stale.clear();
+            m_restart = true;
+            m_done = false;
+        }
+
+        /**
+         * @brief Replaces all of the results at once with the next Drain (background thread)
+         * 
+         * @param batch The new results
+         */
+        void Replace(Entries &&batch)
+        {
+            std::scoped_lock lock{m_lock};
+            m_pending = std::move(batch);
+            m_stale.clear();
+            m_restart = true;
+        }
+
+        /**
+         * @brief Moves the queued entries onto the end of the results and drops stale ones (UI thread)
+         * 
+         * @param entries The results to update
+         * @return true - Entries were appended or removed
+         * @return false - Nothing changed
+         */
+        bool Drain(Entries &entries)
+        {
+            std::scoped_lock lock{m_lock};
+            if (m_pending.empty() && m_stale.empty() && !m_restart)
+            {
+                return false;
+            }
+
+            if (m_restart)
+            {
+                entries.clear();
+                m_restart = false;
+                ++m_generation;
+            }
+
+            if (entries.empty())
+            {
+                entries.swap(m_pending);
+            }
+            else
+            {
+                entries.insert(std::end(entries), std::make_move_iterator(std::begin(m_pending)), std::make_move_iterator(std::end(m_pending)));
+                m_pending.clear();
+            }
+
+            if (!m_stale.empty())
+            {
+                entries.erase(std::remove_if(std::begin(entries), std::end(entries), [this](const std::shared_ptr<Entry> &entry) {
+                                  return m_stale.contains(entry.get());
+                              }),
+                              std::end(entries));
+                m_stale.clear();
+                ++m_generation;
+            }
+
+            return true;
+        }
+
+        /**
+         * @brief Changes each time Drain removed or cleared entries
+         * 
+         * @return size_t The generation for Mode::Generation
+         */
+        size_t Generation() const
+        {
+            std::scoped_lock lock{m_lock};
+            return m_generation;
+        }
+
+        /**
+         * @brief Checks if everything has been loaded and drained
+         * 
+         * @return true - Nothing more to come
+         * @return false - Still loading
+         */
+        bool Done() const
+        {
+            std::scoped_lock lock{m_lock};
+            return m_done && m_pending.empty();
+        }
+
+    private:
+        mutable std::mutex m_lock;
+        Entries m_pending;
+        std::unordered_set<const Entry *> m_stale;
+        size_t m_generation{};
+        bool m_restart{};
+        bool m_done{};
+    };
+} // namespace yaltl
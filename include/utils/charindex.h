@@ -0,0 +1,89 @@
+#pragma once
+
+#include "mode.h"
+#include "utils/frontcoded.h"
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <stop_token>
+#include <string_view>
+#include <vector>
+
+namespace yaltl
+{
+    /**
+     * @brief Which entries contain each character, to narrow down what a search has to scan.
+     *
+     * Searches match their characters in order with anything in between, so only entries containing every
+     * character of the search can match, and intersecting the entries each one is in gives a superset of the matches.
+     * Only ASCII letters and digits are indexed, folded to lower case, each as a list of varint encoded gaps between entries.
+     */
+    class CharIndex
+    {
+    public:
+        /**
+         * @brief Indexes entries, their criteria when they have them
+         *
+         * @param entries The entries to index, they must not change while the index is used
+         * @param budget The most bytes the index may take
+         * @param stop Gives up building when requested
+         * @return std::optional<CharIndex> The index, nullopt if it went over budget or was stopped
+         */
+        static std::optional<CharIndex> build(const Entries &entries, size_t budget, std::stop_token stop);
+
+        //! Indexes the lines of a compact store, the same as entries without criteria
+        static std::optional<CharIndex> build(const FrontCoded &lines, size_t budget, std::stop_token stop);
+
+        /**
+         * @brief Finds the entries that may match a search (any thread)
+         *
+         * @param search The text matched, i.e: matcher::search_text
+         * @return std::optional<std::vector<uint32_t>> Indexes of the entries that may match in order, nullopt when scanning them all is cheaper
+         */
+        std::optional<std::vector<uint32_t>> Candidates(std::wstring_view search) const;
+
+        //! How many entries were indexed
+        size_t Size() const
+        {
+            return m_entries;
+        }
+
+        //! How many bytes the index takes
+        size_t Bytes() const
+        {
+            return m_bytes;
+        }
+
+    private:
+        /**
+         * @brief Adds an entry to the postings of the characters it has, entries must be added in order
+         *
+         * @param entry The entry's index
+         * @param seen The postings it's in, a bit each
+         * @param budget The most bytes the index may take
+         * @return true - Still within budget
+         */
+        bool Add(uint32_t entry, uint64_t seen, size_t budget);
+
+        //! Drops dense postings and trims the rest once every entry was added
+        void Finish();
+
+        //! The entries a character is in
+        struct Posting
+        {
+            //! Gaps between the entries, 7 bits a byte with the high bit set on all but the last byte of each
+            std::vector<uint8_t> gaps;
+            uint32_t count{};
+            uint32_t last{};
+
+            //! In too many entries to narrow anything down, so it isn't kept
+            bool dense{};
+        };
+
+        //! a-z then 0-9
+        std::array<Posting, 36> m_postings;
+        size_t m_entries{};
+        size_t m_bytes{};
+    };
+} // namespace yaltl
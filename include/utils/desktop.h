@@ -0,0 +1,93 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace yaltl
+{
+    namespace desktop
+    {
+        /**
+         * @brief The parts of a freedesktop.org .desktop application entry yaltl cares about
+         *
+         */
+        struct Application
+        {
+            //! The desktop file id (i.e: org.gnome.Terminal.desktop), used for XDG precedence
+            std::string id;
+
+            //! Path to the .desktop file
+            std::filesystem::path path;
+
+            //! The untranslated Name
+            std::string name;
+
+            //! The Name for the current locale, same as name if there's no translation
+            std::string display_name;
+
+            //! The Comment for the current locale
+            std::string description;
+
+            //! The Exec line with field codes still in it
+            std::string exec;
+
+            //! Binary that must exist for the application to be shown
+            std::string try_exec;
+
+            std::string icon;
+
+            //! Desktops the entry should only be shown in
+            std::vector<std::string> only_show_in;
+
+            //! Desktops the entry should not be shown in
+            std::vector<std::string> not_show_in;
+
+            bool no_display{};
+
+            bool hidden{};
+        };
+
+        /**
+         * @brief Parses a .desktop file
+         *
+         * @param path The file to parse
+         * @param locale The locale to pick translated keys for (i.e: en_US@euro)
+         * @return std::optional<Application> The application, or nullopt if the file is not a launchable application
+         */
+        std::optional<Application> parse(const std::filesystem::path &path, std::string_view locale);
+
+        /**
+         * @brief Splits the Exec line into arguments, expanding or removing field codes
+         *
+         * @param app The application to build the arguments for
+         * @return std::vector<std::string> The argv to launch, empty if the Exec line is invalid
+         */
+        std::vector<std::string> expand_exec(const Application &app);
+
+        /**
+         * @brief Checks NoDisplay, Hidden, OnlyShowIn, NotShowIn and TryExec
+         *
+         * @param app The application to check
+         * @return true - The application should be listed
+         * @return false - The application should be hidden
+         */
+        bool should_show(const Application &app);
+
+        /**
+         * @brief Loads all applications from the XDG data directories.
+         *
+         * Earlier directories take precedence over later ones for the same desktop file id.
+         * Files are parsed in parallel, and the results are cached by modification time
+         * under $XDG_CACHE_HOME/yaltl so unchanged files don't need to be parsed again.
+         * Applications from the cache are handed out first, followed by each chunk of parsed files.
+         *
+         * @param on_batch Receives the applications as they load, hidden ones included.
+         *                 May be called from several threads at once.
+         */
+        void load_all(const std::function<void(std::vector<Application> &&)> &on_batch);
+    } // namespace desktop
+} // namespace yaltl
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <stop_token>
+
+namespace yaltl
+{
+    /**
+     * @brief The worker threads everything but the UI and long lived watchers run on.
+     *
+     * Each worker keeps its own queues and steals from the others when it runs dry, work submitted from
+     * outside the pool is shared. More urgent lanes are always taken first, a running job is never interrupted.
+     *
+     */
+    namespace executor
+    {
+        //! What work is for, in the order workers take it
+        enum class Lane
+        {
+            Interactive,
+            Preview,
+            Background
+        };
+
+        namespace details
+        {
+            struct State;
+        } // namespace details
+
+        /**
+         * @brief Submitted work, destroying it cancels the work and waits for it the same as a std::jthread.
+         *
+         */
+        class Job
+        {
+        public:
+            Job() = default;
+            explicit Job(std::shared_ptr<details::State> state);
+            ~Job();
+
+            Job(Job &&) noexcept = default;
+
+            //! Cancels and waits for the work already held first
+            Job &operator=(Job &&other) noexcept;
+
+            //! Asks the work to stop through its stop token, work that hasn't started is skipped (any thread)
+            void Cancel();
+
+            /**
+             * @brief Waits for the work to finish, running it on the calling thread if no worker has started it
+             *
+             * Work that waits on work it submitted can't run out of workers this way.
+             *
+             */
+            void Wait();
+
+            //! If the work has finished or was skipped
+            bool Done() const;
+
+        private:
+            std::shared_ptr<details::State> m_state;
+        };
+
+        /**
+         * @brief Sets how many workers the pool starts with, only before anything is submitted
+         *
+         * @param threads The number of workers, 0 for one per core
+         */
+        void configure(size_t threads);
+
+        //! How many workers the pool has, or will have once something is submitted
+        size_t threads();
+
+        /**
+         * @brief Queues work, starting the pool if it hasn't been (any thread)
+         *
+         * @param lane What the work is for
+         * @param work The work, it should return soon after its stop token is triggered
+         * @return Job The work
+         */
+        Job submit(Lane lane, std::function<void(std::stop_token)> work);
+    } // namespace executor
+} // namespace yaltl
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <stdio.h>
+
+#include <mtl/memory.hpp>
+
+namespace yaltl
+{
+    using unique_file = mtl::unique_ptr<decltype(::fclose), &::fclose>;
+} // namespace yaltl
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace yaltl
+{
+    /**
+     * @brief Lines stored front coded, for inputs too large to keep as entries, i.e: millions of paths.
+     *
+     * Lines are kept as UTF-8 in blocks of BLOCK_LINES, the first line of a block whole and each after it as the
+     * length it shares with the line before and the bytes that differ. Lines are only decoded to wide strings while
+     * they're being looked at, a block at a time into a buffer that's reused.
+     */
+    class FrontCoded
+    {
+    public:
+        static constexpr size_t BLOCK_LINES{16};
+
+        /**
+         * @brief Called with each line decoded
+         *
+         * @param index The line's index
+         * @param line The line, only valid during the call
+         * @return true - Keep going
+         */
+        using Visit = std::function<bool(size_t index, std::wstring_view line)>;
+
+        //! Adds a line to the end
+        void Append(std::string_view line);
+
+        //! Gives back what was reserved for lines that were never added, call once done appending
+        void Shrink();
+
+        //! How many lines there are
+        size_t Size() const
+        {
+            return m_size;
+        }
+
+        //! How many bytes the lines take
+        size_t Bytes() const
+        {
+            return m_data.capacity() + m_blocks.capacity() * sizeof(uint64_t);
+        }
+
+        /**
+         * @brief Decodes a range of lines in order (any thread)
+         *
+         * @param begin The first line
+         * @param end One past the last line
+         * @param visit Called with each line
+         */
+        void Scan(size_t begin, size_t end, const Visit &visit) const;
+
+        /**
+         * @brief Decodes some of the lines (any thread)
+         *
+         * @param indexes The lines, in order
+         * @param visit Called with each line
+         */
+        void Lines(std::span<const uint32_t> indexes, const Visit &visit) const;
+
+    private:
+        std::vector<char> m_data;
+
+        //! Where each block starts in m_data
+        std::vector<uint64_t> m_blocks;
+        size_t m_size{};
+
+        //! The line appended last, what the next one is coded against
+        std::string m_last;
+    };
+} // namespace yaltl
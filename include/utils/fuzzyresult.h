@@ -19,6 +19,9 @@ namespace yaltl
          */
         std::optional<std::wstring_view> match;
 
+        //! The mode the result came from, which executes and previews it
+        Mode *owner{};
+
         /**
          * @brief Compares fuzzy match results
          * 
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace yaltl
+{
+    /**
+     * @brief A fixed size latency histogram in the style of HdrHistogram.
+     * 
+     * Each power of two range is split into the same number of linear buckets,
+     * so any recorded value is kept to within about 3% no matter its size,
+     * and recording is a couple of shifts and an increment.
+     * 
+     */
+    class Histogram
+    {
+    public:
+        //! Each power of two is split into 2^SUB_BITS buckets
+        static constexpr unsigned SUB_BITS{5};
+
+        //! Values past 2^MAX_BITS are counted as the largest bucket
+        static constexpr unsigned MAX_BITS{40};
+
+        static constexpr size_t BUCKETS{(MAX_BITS - SUB_BITS + 1) << SUB_BITS};
+
+        /**
+         * @brief Counts a value
+         * 
+         * @param value The value, i.e: nanoseconds
+         */
+        void Record(uint64_t value);
+
+        /**
+         * @brief Finds the value at a percentile
+         * 
+         * @param percentile 0 to 100
+         * @return uint64_t The highest value of the bucket the percentile falls in, 0 when empty
+         */
+        uint64_t Percentile(double percentile) const;
+
+        uint64_t Count() const
+        {
+            return m_count;
+        }
+
+        uint64_t Min() const
+        {
+            return m_count ? m_min : 0;
+        }
+
+        uint64_t Max() const
+        {
+            return m_max;
+        }
+
+        double Mean() const
+        {
+            return m_count ? static_cast<double>(m_total) / m_count : 0;
+        }
+
+        //! The summary and the non-empty buckets as a JSON object
+        std::string Json() const;
+
+    private:
+        static size_t Index(uint64_t value);
+
+        //! The highest value that lands in a bucket
+        static uint64_t Highest(size_t index);
+
+    private:
+        std::array<uint64_t, BUCKETS> m_buckets{};
+        uint64_t m_count{};
+        uint64_t m_total{};
+        uint64_t m_min{UINT64_MAX};
+        uint64_t m_max{};
+    };
+} // namespace yaltl
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace yaltl
+{
+    namespace i3
+    {
+        //! Message types from the i3 IPC protocol, shared by sway
+        enum class Message : uint32_t
+        {
+            RunCommand = 0,
+            GetWorkspaces = 1,
+            Subscribe = 2,
+            GetTree = 4,
+        };
+
+        //! Event types, events have the high bit set to tell them apart from replies
+        enum class Event : uint32_t
+        {
+            Workspace = 0x80000000,
+            Window = 0x80000003,
+        };
+
+        /**
+         * @brief A connection to the i3 or sway IPC socket
+         * 
+         */
+        class Connection
+        {
+        public:
+            //! Connects to $SWAYSOCK, $I3SOCK or the socket i3 reports
+            Connection();
+            ~Connection();
+
+            Connection(const Connection &) = delete;
+            Connection &operator=(const Connection &) = delete;
+
+            bool Connected() const
+            {
+                return m_fd >= 0;
+            }
+
+            //! The socket, to poll for events
+            int Fd() const
+            {
+                return m_fd;
+            }
+
+            /**
+             * @brief Sends a message and waits for the reply
+             * 
+             * @param type The message type
+             * @param payload The message payload
+             * @return std::optional<std::string> The reply payload, nullopt if the connection failed
+             */
+            std::optional<std::string> Request(Message type, std::string_view payload = {});
+
+            /**
+             * @brief Runs a command
+             * 
+             * @param command The command, several can be batched separated by ;
+             * @return true - Every command succeeded
+             */
+            bool Command(std::string_view command);
+
+            /**
+             * @brief Subscribes to events, the connection should only be used to Read them afterwards
+             * 
+             * @param events JSON array of event names, i.e: ["window","workspace"]
+             * @return true - Subscribed
+             */
+            bool Subscribe(std::string_view events);
+
+            /**
+             * @brief Reads the next message, blocking until one arrives
+             * 
+             * @param type [Out] The message or event type
+             * @param payload [Out] The payload
+             * @return true - A message was read
+             */
+            bool Read(uint32_t &type, std::string &payload);
+
+        private:
+            bool Send(Message type, std::string_view payload);
+
+        private:
+            int m_fd{-1};
+        };
+    } // namespace i3
+} // namespace yaltl
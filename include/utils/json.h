@@ -0,0 +1,145 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace yaltl
+{
+    namespace json
+    {
+        /**
+         * @brief A forward only cursor over a JSON document.
+         * 
+         * Nothing is built up front, callers pull out the values they care about
+         * and skip the rest, so only the extracted strings allocate.
+         * 
+         */
+        class Scanner
+        {
+        public:
+            explicit Scanner(std::string_view json) : m_json(json)
+            {
+            }
+
+            /**
+             * @brief Reads the object at the cursor
+             * 
+             * @tparam OnKey bool(std::string_view key), must consume the value, i.e: by calling Skip
+             * @param on_key Called for each member with the raw key
+             * @return true - The object was read, and on_key returned true for each member
+             */
+            template <class OnKey>
+            bool Object(OnKey &&on_key)
+            {
+                if (!Consume('{'))
+                {
+                    return false;
+                }
+
+                if (Consume('}'))
+                {
+                    return true;
+                }
+
+                do
+                {
+                    std::string_view key;
+                    if (!RawString(key) || !Consume(':') || !on_key(key))
+                    {
+                        return false;
+                    }
+                } while (Consume(','));
+
+                return Consume('}');
+            }
+
+            /**
+             * @brief Reads the array at the cursor
+             * 
+             * @tparam OnItem bool(), must consume the item
+             * @param on_item Called for each item
+             * @return true - The array was read, and on_item returned true for each item
+             */
+            template <class OnItem>
+            bool Array(OnItem &&on_item)
+            {
+                if (!Consume('['))
+                {
+                    return false;
+                }
+
+                if (Consume(']'))
+                {
+                    return true;
+                }
+
+                do
+                {
+                    if (!on_item())
+                    {
+                        return false;
+                    }
+                } while (Consume(','));
+
+                return Consume(']');
+            }
+
+            /**
+             * @brief Reads a string, unescaping it
+             * 
+             * @param out [Out] The UTF-8 string
+             * @return true - A string was read
+             */
+            bool String(std::string &out);
+
+            bool Number(uint64_t &out);
+
+            bool Bool(bool &out);
+
+            /**
+             * @brief Consumes null if it is at the cursor
+             * 
+             * @return true - The value was null
+             * @return false - The value was something else and was left alone
+             */
+            bool Null();
+
+            /**
+             * @brief Skips over the value at the cursor
+             * 
+             * @return true - A well formed value was skipped
+             */
+            bool Skip();
+
+        private:
+            void SkipSpace();
+
+            /**
+             * @brief Consumes the character if it is next, ignoring whitespace
+             * 
+             */
+            bool Consume(char ch);
+
+            /**
+             * @brief Reads a string without unescaping it
+             * 
+             * @param out [Out] The string as it is in the document
+             * @return true - A string was read
+             */
+            bool RawString(std::string_view &out);
+
+        private:
+            std::string_view m_json;
+            size_t m_pos{};
+        };
+
+        /**
+         * @brief Quotes and escapes a string for writing JSON
+         * 
+         * @param text The UTF-8 string
+         * @return std::string The string as a JSON value, i.e: "say \"hi\""
+         */
+        std::string quote(std::string_view text);
+    } // namespace json
+} // namespace yaltl
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace yaltl
+{
+    /**
+     * @brief A fixed size cache that drops the least recently used value when full.
+     *
+     * @tparam Key Must be hashable
+     * @tparam Value The cached value
+     */
+    template <typename Key, typename Value>
+    class Lru
+    {
+    public:
+        explicit Lru(size_t capacity) : m_capacity(capacity)
+        {
+        }
+
+        /**
+         * @brief Looks up a value, marking it as the most recently used
+         *
+         * @param key The key to look for
+         * @return const Value* The value, or nullptr if it isn't cached
+         */
+        const Value *Find(const Key &key)
+        {
+            auto itr{m_index.find(key)};
+            if (itr == std::end(m_index))
+            {
+                return nullptr;
+            }
+
+            m_order.splice(std::begin(m_order), m_order, itr->second);
+            return &itr->second->second;
+        }
+
+        /**
+         * @brief Adds or replaces a value, evicting the least recently used one if full
+         *
+         * @param key The key to store under
+         * @param value The value to cache
+         */
+        void Put(const Key &key, Value value)
+        {
+            if (auto itr{m_index.find(key)}; itr != std::end(m_index))
+            {
+                itr->second->second = std::move(value);
+                m_order.splice(std::begin(m_order), m_order, itr->second);
+                return;
+            }
+
+            if (m_order.size() >= m_capacity && !m_order.empty())
+            {
+                m_index.erase(m_order.back().first);
+                m_order.pop_back();
+            }
+
+            m_order.emplace_front(key, std::move(value));
+            m_index.emplace(key, std::begin(m_order));
+        }
+
+        void Clear()
+        {
+            m_index.clear();
+            m_order.clear();
+        }
+
+    private:
+        size_t m_capacity;
+
+        //! Most recently used first
+        std::list<std::pair<Key, Value>> m_order;
+        std::unordered_map<Key, typename std::list<std::pair<Key, Value>>::iterator> m_index;
+    };
+} // namespace yaltl
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "mode.h"
+#include "utils/frontcoded.h"
+#include "utils/fuzzyresult.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace yaltl
+{
+    namespace matcher
+    {
+        /**
+         * @brief Gets the part of the search entries are matched against
+         * 
+         * @param search The search as typed
+         * @param firstWordOnly Only the first word is matched, i.e: the rest are arguments
+         * @return std::wstring_view The text to match
+         */
+        std::wstring_view search_text(const std::wstring &search, bool firstWordOnly);
+
+        /**
+         * @brief Ranks entries against a search, the same way the results list does
+         * 
+         * @param begin The first entry to rank
+         * @param end The end of the entries to rank
+         * @param search The search as typed
+         * @param firstWordOnly Only the first word of the search is matched
+         * @param exact [Out] How many of the results contain the search as is, they are ranked first
+         * @return std::vector<FuzzyResult> The matching entries, best first
+         */
+        std::vector<FuzzyResult> rank(Entries::const_iterator begin, Entries::const_iterator end, const std::wstring &search, bool firstWordOnly, size_t &exact);
+
+        /**
+         * @brief Ranks the lines of a compact store the same way, only the best become entries
+         * 
+         * @param lines The lines to rank
+         * @param candidates Only rank these lines, i.e: from Mode::Candidates, nullopt for all of them
+         * @param search The search as typed
+         * @param firstWordOnly Only the first word of the search is matched
+         * @param limit The most results to make entries of
+         * @param exact [Out] How many of the results contain the search as is, they are ranked first
+         * @return std::vector<FuzzyResult> The best matching lines as entries, best first
+         */
+        std::vector<FuzzyResult> rank(const FrontCoded &lines, const std::optional<std::vector<uint32_t>> &candidates, const std::wstring &search, bool firstWordOnly, size_t limit, size_t &exact);
+    } // namespace matcher
+} // namespace yaltl
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "mode.h"
+#include "utils/executor.h"
+#include "utils/lru.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <thread>
+
+namespace yaltl
+{
+    /**
+     * @brief Builds previews on the executor's preview lane so slow previews never hold up rendering.
+     *
+     * Requests are debounced on the previewer's thread while the selection keeps moving, a request
+     * that gets superseded is cancelled through its stop token, and finished previews are cached per entry.
+     * Entries without a preview aren't cached, they're built again the next time they're selected.
+     */
+    class Previewer
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        /**
+         * @brief Construct a new Previewer object
+         *
+         * @param refresh Wakes up the UI thread when a preview is ready, called from an executor worker
+         */
+        explicit Previewer(std::function<void()> refresh);
+
+        /**
+         * @brief Gets the preview for an entry, asking for it to be built if it isn't cached (UI thread)
+         *
+         * @param mode The mode the entry belongs to, must outlive the previewer
+         * @param entry The entry to preview
+         * @return std::optional<ftxui::Element> The preview once it's ready, which may be nullptr if the mode has none
+         */
+        std::optional<ftxui::Element> Get(Mode &mode, const std::shared_ptr<Entry> &entry);
+
+    private:
+        struct Request
+        {
+            Mode *mode;
+            std::shared_ptr<Entry> entry;
+            Clock::time_point due;
+        };
+
+        void Run(std::stop_token stop);
+
+        /**
+         * @brief Builds a preview and caches it unless it was cancelled
+         *
+         * @param request What to preview
+         * @param cancel Set once the preview is no longer wanted
+         */
+        void Build(const Request &request, std::stop_token cancel);
+
+    private:
+        std::function<void()> m_refresh;
+
+        std::mutex m_lock;
+        std::condition_variable_any m_wake;
+
+        //! The entry last asked for, so asking again every frame doesn't restart the debounce
+        std::shared_ptr<Entry> m_requested;
+        std::optional<Request> m_pending;
+
+        //! Holding on to the entries keeps their addresses from being reused by other entries
+        Lru<std::shared_ptr<Entry>, ftxui::Element> m_cache;
+
+        //! The entry last built without a preview, only until the selection moves on
+        std::shared_ptr<Entry> m_missing;
+
+        //! The preview being built, declared after what it uses
+        executor::Job m_building;
+
+        //! Declared last so the thread stops before the rest is destroyed
+        std::jthread m_worker;
+    };
+} // namespace yaltl
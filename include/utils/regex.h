@@ -5,6 +5,7 @@
 #include <optional>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #ifndef PCRE2_FOUND
 #include "./regex/regex_stl.h"
@@ -29,6 +30,17 @@ namespace yaltl
          * @return std::optional<std::basic_string<CharT>> The fuzz found.
          */
         std::optional<std::wstring_view> fuzzy_find(std::wstring_view outer, const regex_t &search);
+
+        /**
+         * @brief Finds which characters a search matched, the tightest case insensitive match wins.
+         * 
+         * Much slower than fuzzy_find, so only meant for results being shown.
+         * 
+         * @param outer The string that was matched.
+         * @param search The search as typed, whitespace is skipped the same as build_pattern.
+         * @return std::vector<size_t> Indexes into outer of the matched characters, empty when it doesn't match.
+         */
+        std::vector<size_t> match_positions(std::wstring_view outer, std::wstring_view search);
     } // namespace regex
 
 } // namespace yaltl
@@ -7,9 +7,11 @@ namespace yaltl
     /**
      * @brief Spawn a process that will outlive the parent process.
      * 
+     * Returns as soon as the process was started, without waiting on it.
+     * 
      * @param command The command to run to start the process
-     * @return true - Process most likely started
-     * @return false - Process most likely not started
+     * @return true - Process started
+     * @return false - Process not started, errno has the reason on posix
      */
     bool spawn(Command command);
 } // namespace yaltl
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <chrono>
+#include <optional>
+#include <string>
+
+namespace yaltl
+{
+    /**
+     * @brief Times each stage of handling a keystroke, for --stats.
+     * 
+     * Off by default, then a timer costs one check. Only the thread that started timing is timed,
+     * so work shared with the executor's workers doesn't race on the histograms.
+     * 
+     */
+    namespace stats
+    {
+        using Clock = std::chrono::steady_clock;
+
+        enum class Stage
+        {
+            //! Building the regex from the search
+            Compile,
+
+            //! Matching the regex against every candidate
+            Scan,
+
+            //! Sorting and filtering the matches
+            Rank,
+
+            //! Building the frame
+            Render,
+
+            //! Writing the frame out to the terminal
+            Flush,
+
+            Count
+        };
+
+        namespace details
+        {
+            //! Only set on the thread that called start
+            extern thread_local bool t_enabled;
+        } // namespace details
+
+        inline bool enabled()
+        {
+            return details::t_enabled;
+        }
+
+        /**
+         * @brief Starts timing, the terminal writes are timed by wrapping std::cout
+         * 
+         * @param file Where the histograms are written by stop, stderr when empty
+         * @return true - file could be opened and timing started
+         */
+        bool start(const std::string &file);
+
+        //! Stops timing and writes the histograms as JSON
+        void stop();
+
+        /**
+         * @brief Records how long a stage took
+         * 
+         * @param stage The stage
+         * @param duration How long it took
+         */
+        void record(Stage stage, Clock::duration duration);
+
+        /**
+         * @brief Records the size of the last search
+         * 
+         * @param candidates How many entries were searched
+         * @param matches How many of them matched
+         */
+        void matched(size_t candidates, size_t matches);
+
+        /**
+         * @brief Records how long the last frame took to write, call before building the next one
+         * 
+         */
+        void frame();
+
+        //! The last and p99 timings of each stage and the last search's size
+        std::wstring status();
+
+        //! Records the time from construction to destruction as a stage
+        class Timer
+        {
+        public:
+            explicit Timer(Stage stage) : m_stage(stage)
+            {
+                if (enabled())
+                {
+                    m_begin = Clock::now();
+                }
+            }
+
+            ~Timer()
+            {
+                if (m_begin.has_value())
+                {
+                    record(m_stage, Clock::now() - m_begin.value());
+                }
+            }
+
+            Timer(const Timer &) = delete;
+            Timer &operator=(const Timer &) = delete;
+
+        private:
+            Stage m_stage;
+            std::optional<Clock::time_point> m_begin;
+        };
+    } // namespace stats
+} // namespace yaltl
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace yaltl
+{
+    namespace subprocess
+    {
+        struct Options
+        {
+            //! The program and its arguments, the program is looked up on PATH
+            std::vector<std::string> argv;
+
+            //! Run argv[0] as a shell command line instead
+            bool shell{};
+
+            //! Kill the process if it runs longer than this
+            std::optional<std::chrono::milliseconds> timeout;
+
+            //! Kill the process when requested
+            std::stop_token stop;
+
+            //! Receives each group of complete lines as soon as they're read, the views are only valid during the call
+            std::function<void(const std::vector<std::string_view> &)> on_lines;
+        };
+
+        struct Output
+        {
+            //! Everything the process printed, a vector since moving it keeps the lines pointing into it
+            std::vector<char> buffer;
+
+            //! The lines in buffer, empty ones left out
+            std::vector<std::string_view> lines;
+
+            //! The exit code, or the negated signal that ended the process, nullopt if it couldn't be started
+            std::optional<int> status;
+
+            //! Set if the process was killed for running past the timeout or being stopped
+            bool killed{};
+        };
+
+        /**
+         * @brief Runs a process and collects its output.
+         *
+         * The output is read with large reads into a single buffer, and lines are handed out
+         * as views into it rather than being copied. stdin is /dev/null.
+         *
+         * @param options What to run and how
+         * @return Output What it printed and how it exited
+         */
+        Output run(Options options);
+    } // namespace subprocess
+} // namespace yaltl
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <ftxui/screen/terminal.hpp>
+
+namespace yaltl
+{
+    namespace terminal
+    {
+        /**
+         * @brief Gets the terminal size, only asking the terminal again once it was resized
+         *
+         * @return ftxui::Terminal::Dimensions The size in cells
+         */
+        ftxui::Terminal::Dimensions size();
+
+        /**
+         * @brief Checks if the terminal was resized since the size was last read
+         *
+         * @return true - size will return something new
+         */
+        bool resized();
+
+        /**
+         * @brief Stops asking the terminal, i.e: to replay against a virtual terminal
+         * 
+         * @param size The size to report from now on
+         */
+        void pin(ftxui::Terminal::Dimensions size);
+    } // namespace terminal
+} // namespace yaltl
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+
+namespace yaltl
+{
+    /**
+     * @brief Coalesces requests from any thread into calls spaced at least an interval apart.
+     *
+     * Any number of requests made before the call goes out are served by that one call.
+     * A request while idle goes out right away, so only bursts get held back.
+     */
+    class Throttle
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        /**
+         * @brief Construct a new Throttle object
+         *
+         * @param call What to call, called from the throttle's thread
+         * @param interval The least time between calls
+         */
+        Throttle(std::function<void()> call, Clock::duration interval);
+
+        /**
+         * @brief Asks for a call (any thread)
+         *
+         */
+        void Request();
+
+    private:
+        void Run(std::stop_token stop);
+
+    private:
+        std::function<void()> m_call;
+        Clock::duration m_interval;
+
+        std::mutex m_lock;
+        std::condition_variable_any m_wake;
+        bool m_requested{};
+
+        //! Declared last so the thread stops before the rest is destroyed
+        std::jthread m_worker;
+    };
+} // namespace yaltl
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <string_view>
+
+namespace yaltl
+{
+    /**
+     * @brief Records timed spans and writes them out as a Chrome trace_event timeline (chrome://tracing, Perfetto).
+     * 
+     * Off by default, a span then costs one relaxed load.
+     * 
+     */
+    namespace trace
+    {
+        using Clock = std::chrono::steady_clock;
+
+        namespace details
+        {
+            extern std::atomic<bool> g_enabled;
+        } // namespace details
+
+        inline bool enabled()
+        {
+            return details::g_enabled.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Starts recording
+         * 
+         * @param file Where the timeline is written by stop
+         * @param origin When the timeline starts, i.e: when the process started
+         * @return true - file could be opened and recording started
+         */
+        bool start(const std::string &file, Clock::time_point origin);
+
+        //! Stops recording and writes the timeline
+        void stop();
+
+        /**
+         * @brief Records a span that already happened
+         * 
+         * @param name What happened
+         * @param begin When it started
+         * @param end When it finished
+         */
+        void complete(std::string name, Clock::time_point begin, Clock::time_point end);
+
+        /**
+         * @brief Records a point in time
+         * 
+         * @param name What happened
+         */
+        void mark(std::string name);
+
+        //! Records the time from construction to destruction on the calling thread
+        class Span
+        {
+        public:
+            explicit Span(std::string_view name)
+            {
+                if (enabled())
+                {
+                    m_name = name;
+                    m_begin = Clock::now();
+                    m_active = true;
+                }
+            }
+
+            ~Span()
+            {
+                if (m_active)
+                {
+                    complete(std::move(m_name), m_begin, Clock::now());
+                }
+            }
+
+            Span(const Span &) = delete;
+            Span &operator=(const Span &) = delete;
+
+        private:
+            std::string m_name;
+            Clock::time_point m_begin;
+            bool m_active{};
+        };
+    } // namespace trace
+} // namespace yaltl
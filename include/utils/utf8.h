@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace yaltl
+{
+    namespace utf8
+    {
+        /**
+         * @brief Converts UTF-8 to a wide string the same as std::codecvt_utf8_utf16, except it never throws
+         *
+         * Bytes that aren't valid UTF-8, i.e: truncated sequences, overlong forms and surrogates, become U+FFFD.
+         *
+         * @param in The UTF-8 text
+         * @param out [Out] Replaced with the text, characters past U+FFFF as surrogate pairs
+         */
+        void widen(std::string_view in, std::wstring &out);
+
+        //! Converts UTF-8 to a wide string, bytes that aren't valid UTF-8 become U+FFFD
+        std::wstring widen(std::string_view in);
+    } // namespace utf8
+} // namespace yaltl
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <functional>
+#include <istream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace yaltl
+{
+    namespace xml
+    {
+        using Attributes = std::vector<std::pair<std::string, std::string>>;
+
+        /**
+         * @brief Callbacks for the parts of the document as they are read
+         * 
+         */
+        struct Handler
+        {
+            //! An element was opened, with its attributes unescaped
+            std::function<void(std::string_view name, const Attributes &attributes)> on_start;
+
+            //! An element was closed, self closing elements get both on_start and on_end
+            std::function<void(std::string_view name)> on_end;
+
+            //! Unescaped text between tags
+            std::function<void(std::string_view text)> on_text;
+        };
+
+        /**
+         * @brief Looks up an attribute by name
+         * 
+         * @param attributes The attributes of an element
+         * @param name The attribute to find
+         * @return std::optional<std::string_view> The value if the attribute is present
+         */
+        std::optional<std::string_view> attribute(const Attributes &attributes, std::string_view name);
+
+        /**
+         * @brief Reads the document from the stream, calling handler as it goes without building a tree.
+         * 
+         * Comments, processing instructions and DOCTYPE declarations are skipped.
+         * 
+         * @param input The document
+         * @param handler The callbacks
+         * @return true - The whole document was read
+         * @return false - The document was malformed, callbacks may have already been called
+         */
+        bool parse(std::istream &input, const Handler &handler);
+    } // namespace xml
+} // namespace yaltl
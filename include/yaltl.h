@@ -3,12 +3,17 @@
 #include <ftxui/component/component.hpp>
 #include <ftxui/component/container.hpp>
 #include <ftxui/component/input.hpp>
-#include <ftxui/component/menu.hpp>
+#include <atomic>
+#include <memory>
 #include <regex>
+#include <unordered_map>
 
 #include "mode.h"
+#include "utils/executor.h"
 #include "utils/fuzzyresult.h"
+#include "utils/previewer.h"
 #include "utils/regex.h"
+#include "utils/throttle.h"
 
 namespace yaltl
 {
@@ -21,27 +26,175 @@ namespace yaltl
     class Yaltl : public ftxui::Component
     {
     public:
-        Yaltl(Modes &&);
+        /**
+         * @brief Construct a new Yaltl object
+         * 
+         * @param modes The modes to switch between
+         * @param refresh Wakes up the UI thread to pick up results modes loaded in the background, called from any thread
+         */
+        Yaltl(Modes &&modes, std::function<void()> refresh);
 
         void Execute();
+
+        //! Runs the search if it's pending and waits for every source to be ranked, so the results don't depend on timing
+        void FinishSearch();
+
+        /**
+         * @brief Does what the mode asked for after executing
+         * 
+         * @param postAction What the mode asked for
+         */
+        void Apply(PostExec postAction);
         void NextMode();
         void PreviousMode();
         void Move(yaltl::Move move);
         bool OnEvent(ftxui::Event) override;
         ftxui::Element Render() override;
 
+        //! The mode being searched
+        const Mode &ActiveMode() const
+        {
+            return *m_modes[m_mode];
+        }
+
+        /**
+         * @brief Gets the selected result
+         * 
+         * @return std::shared_ptr<Entry> The result, nullptr when nothing matches
+         */
+        std::shared_ptr<Entry> Selected() const
+        {
+            return m_selected < m_activeResults.size() ? m_activeResults[m_selected].result : nullptr;
+        }
+
         std::function<void(int)> on_exit;
 
+        //! Called with the result and the search right before the mode executes it
+        std::function<void(const Entry &, const std::wstring &)> on_execute;
+
+        //! Called once the first frame has been built, for work that shouldn't hold it up
+        std::function<void()> on_first_frame;
+
     private:
-        //! Load entries from mode if needed
+        //! Search all entries from the mode again
         void UpdateEntries();
 
+        /**
+         * @brief Search only the entries the mode loaded since the last search
+         * 
+         * @return true - The results changed
+         */
+        bool RefreshEntries();
+
+        /**
+         * @brief Ranks the entries each source loaded since it was last searched
+         *
+         * A single source is ranked right away, combined ones each on a worker so a slow one doesn't hold the others back.
+         * The rankings are added to m_rankings, MergeRankings picks up the ones that are done.
+         */
+        void SearchSources();
+
+        /**
+         * @brief Merges the rankings that are done into the results, dropping those of searches that were replaced
+         *
+         * @return true - Results were merged
+         */
+        bool MergeRankings();
+
+        /**
+         * @brief Renders the results that fit, with the characters that matched highlighted
+         * 
+         * @param rows How many rows fit
+         * @return ftxui::Element The visible results
+         */
+        ftxui::Element RenderResults(size_t rows);
+
+        //! Renders the preview pane for the selected result
+        ftxui::Element RenderPreview();
+
     private:
         ftxui::Container m_container;
         ftxui::Input m_search;
-        ftxui::Menu m_results;
         int32_t m_mode{};
+
+        //! Index of the selected result
+        size_t m_selected{};
+
+        //! Index of the first result shown
+        size_t m_top{};
+
+        //! Wakes up the UI thread for background updates and searches, declared before the modes so it outlives them
+        Throttle m_updates;
+
         Modes m_modes;
         std::vector<FuzzyResult> m_activeResults;
+
+        //! Number of results in m_activeResults that contain the search as is
+        size_t m_exact{};
+
+        //! A mode whose entries are searched, the active mode or the modes it combines
+        struct Source
+        {
+            Mode *mode;
+
+            //! Number of the mode's entries that have been searched
+            size_t searched{};
+
+            //! The mode's generation when it was last searched
+            size_t generation{};
+        };
+
+        std::vector<Source> m_sources;
+
+        //! The entries of a source ranked for a search, merged into m_activeResults once done
+        struct Ranking
+        {
+            //! The search it was started for, see m_searchGeneration
+            size_t search{};
+
+            //! Copy of the entries ranked on a worker, the mode may load more into its own meanwhile
+            Entries entries;
+
+            std::vector<FuzzyResult> results;
+
+            //! Number of results that contain the search as is
+            size_t exact{};
+
+            //! Set once results are ready (any thread)
+            std::atomic<bool> done{};
+
+            //! Declared last so the work is stopped before the rest is destroyed
+            executor::Job job;
+        };
+
+        //! Rankings that haven't been merged yet, declared after the modes since they use them
+        std::vector<std::unique_ptr<Ranking>> m_rankings;
+
+        //! Counts the searches started, rankings from an older search are dropped
+        size_t m_searchGeneration{};
+
+        //! Set when the search changed but hasn't been run yet
+        bool m_searchPending{};
+
+        //! Set when the next frame needs to be built again
+        bool m_dirty{true};
+
+        //! If the mode was loading when the frame was built
+        bool m_loading{};
+
+        //! Set while the preview pane is waiting on a preview
+        bool m_previewPending{};
+
+        //! The last frame built
+        ftxui::Element m_frame;
+
+        //! Matched characters of the results last shown, ranking doesn't find them so only the shown ones pay for it
+        std::unordered_map<std::shared_ptr<Entry>, std::vector<size_t>> m_highlights;
+
+        //! The search as typed m_highlights were found for
+        std::wstring m_highlighted;
+
+        //! Declared after the modes so previews stop being built before the modes go away
+        Previewer m_previewer;
     };
 } // namespace yaltl
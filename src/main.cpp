@@ -1,8 +1,14 @@
 #include <YaltlConfig.h>
 
 #include "yaltl.h"
+#include "modes/combi.h"
 #include "modes/dmenu.h"
-#ifdef GIOMM_FOUND
+#include "modes/lazy.h"
+#ifdef COPROCESS_FOUND
+#include "modes/coprocess.h"
+#endif
+
+#ifdef DRUN_FOUND
 #include "modes/drun.h"
 #endif
 
@@ -10,13 +16,25 @@
 #include "modes/i3wm.h"
 #endif
 
-#ifdef GTKMM_FOUND
+#ifdef RECENT_FOUND
 #include "modes/recent.h"
 #endif
 
 #include "modes/run.h"
 #include "modes/script.h"
+#include "session.h"
+#include "utils/executor.h"
+#include "utils/matcher.h"
+#include "utils/stats.h"
+#include "utils/trace.h"
+#include "utils/utf8.h"
 
+#include <charconv>
+#include <chrono>
+#include <codecvt>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
 #include <getopt.h>
 #include <ftxui/component/screen_interactive.hpp>
 #include <mtl/string.hpp>
@@ -25,12 +43,39 @@ struct LaunchMode
 {
 	std::string_view mode;
 	std::optional<std::string_view> script;
+
+	//! Keep the script running and talk to it with JSON
+	bool persist{};
+
+	//! Cache the script's output for this long
+	std::optional<std::chrono::seconds> ttl;
 };
 
 struct LaunchOptions
 {
 	bool dmenu{};
 	std::vector<LaunchMode> modes;
+
+	//! Rank stdin against this and print the matches instead of showing the UI
+	std::optional<std::string> filter;
+
+	//! Keep stdin in a compact store instead of as entries
+	bool compact{};
+
+	//! Write the keys pressed here
+	std::optional<std::string> record;
+
+	//! Replay the keys recorded here instead of showing the UI
+	std::optional<std::string> replay;
+
+	//! Write a Chrome trace of the session here
+	std::optional<std::string> trace;
+
+	//! Time each keystroke, writing the histograms here (stderr when empty)
+	std::optional<std::string> stats;
+
+	//! Worker threads for loading, previews and searching, 0 for one per core
+	size_t threads{};
 };
 
 void help()
@@ -39,18 +84,26 @@ void help()
 			  << "\tyaltl [--options]" << std::endl
 			  << "Options:" << std::endl;
 	std::cout << "\t-d, --dmenu\tRun in dmenu mode" << std::endl;
+	std::cout << "\t-f, --filter QUERY\tWith -d, print the lines matching QUERY best first and exit without the UI" << std::endl;
+	std::cout << "\t    --compact\tWith -d, keep the lines front coded for inputs of millions of paths, listing the best 10000 matches" << std::endl;
 	std::cout << "\t-m, --modes\tStart with modes enabled [drun,run,i3wm]" << std::endl
+			  << "\t    --trace FILE\tWrite a Chrome trace_event timeline of the session to FILE" << std::endl
+			  << "\t    --stats[=FILE]\tShow keystroke timings under the prompt, writing latency histograms to FILE (or stderr) on exit" << std::endl
+			  << "\t    --record FILE\tRecord the keys pressed to FILE" << std::endl
+			  << "\t    --replay FILE\tReplay keys recorded to FILE against a virtual terminal, printing per key latency as JSON" << std::endl
+			  << "\t    --threads N\tUse N worker threads for loading, previews and searching, defaults to one per core" << std::endl
 			  << "\t-h, --help \tDisplay this message" << std::endl
 			  << "Modes:" << std::endl;
-#ifdef GIOMM_FOUND
+#ifdef DRUN_FOUND
 	std::cout << "\tdrun\tRun from list of desktop installed applications" << std::endl;
 #endif
 
-#ifdef GTKMM_FOUND
-	std::cout << "\recent\tOpen a recently opened file" << std::endl;
+#ifdef RECENT_FOUND
+	std::cout << "\trecent\tOpen a recently opened file" << std::endl;
 #endif
 
 	std::cout << "\trun \tRun from binaries on $PATH" << std::endl;
+	std::cout << "\tcombi\tSearch all the other modes at once" << std::endl;
 #ifdef I3IPC_FOUND
 	std::cout << "\ti3wm\tSwitch between active windows using i3ipc" << std::endl;
 #endif
@@ -60,7 +113,20 @@ void help()
 			  << "\t\t -m list:ls" << std::endl
 			  << std::endl
 			  << "\tcommand will be called with selected result" << std::endl
-			  << "\tyaltl will stay open as long as command prints output" << std::endl;
+			  << "\tyaltl will stay open as long as command prints output" << std::endl
+			  << std::endl
+			  << "\tPass disp@ttl=seconds:command to cache the output, refreshing it in the background once older" << std::endl
+			  << "\t\t -m hosts@ttl=3600:list-hosts" << std::endl;
+
+#ifdef COPROCESS_FOUND
+	std::cout << "\tPass disp@persist:command to keep the script running" << std::endl
+			  << "\t\t -m files@persist:./picker.py" << std::endl
+			  << std::endl
+			  << "\tcommand reads JSON lines from stdin:" << std::endl
+			  << "\t\t{\"event\":\"query\",\"text\":...} {\"event\":\"select\",\"text\":...,\"query\":...}" << std::endl
+			  << "\tand prints JSON lines to stdout:" << std::endl
+			  << "\t\t{\"replace\":[...]} {\"append\":[...]} {\"close\":true}" << std::endl;
+#endif
 
 	exit(-1);
 }
@@ -74,15 +140,30 @@ LaunchOptions parse_args(int argc, char **argv)
 		modes,
 		dmenu,
 		help,
+		trace,
+		stats,
+		filter,
+		record,
+		replay,
+		threads,
+		compact,
 	};
 
 	static option options[] = {
 		{"modes", required_argument, nullptr, 0},
 		{"dmenu", no_argument, nullptr, 0},
 		{"help", no_argument, nullptr, 0},
+		{"trace", required_argument, nullptr, 0},
+		{"stats", optional_argument, nullptr, 0},
+		{"filter", required_argument, nullptr, 0},
+		{"record", required_argument, nullptr, 0},
+		{"replay", required_argument, nullptr, 0},
+		{"threads", required_argument, nullptr, 0},
+		{"compact", no_argument, nullptr, 0},
+		{nullptr, 0, nullptr, 0},
 	};
 
-	for (int index{}, code{getopt_long(argc, argv, "m:dh", options, &index)}; code >= 0; code = getopt_long(argc, argv, "m:dh", options, &index))
+	for (int index{}, code{getopt_long(argc, argv, "m:dhf:", options, &index)}; code >= 0; code = getopt_long(argc, argv, "m:dhf:", options, &index))
 	{
 		switch (code)
 		{
@@ -95,6 +176,12 @@ LaunchOptions parse_args(int argc, char **argv)
 		case 'h':
 			index = static_cast<int>(Option::help);
 			break;
+		case 'f':
+			index = static_cast<int>(Option::filter);
+			break;
+		case '?':
+			// getopt already said what was wrong, index is still the last option's
+			continue;
 		}
 
 		switch (static_cast<Option>(index))
@@ -111,10 +198,36 @@ LaunchOptions parse_args(int argc, char **argv)
 
 			launch.modes.reserve(modes.size());
 			std::transform(std::begin(modes), std::end(modes), std::back_inserter(launch.modes), [](std::string_view mode) {
-				std::vector<std::string_view> parts;
-				parts.reserve(2);
-				mtl::string::split(mode, ":", std::back_inserter(parts));
-				return parts.size() == 1 ? LaunchMode{parts[0], std::nullopt} : LaunchMode{parts[0], parts[1]};
+				// Only split on the first colon, the command may have more
+				const size_t colon{mode.find(':')};
+				if (colon == std::string_view::npos)
+				{
+					return LaunchMode{mode, std::nullopt};
+				}
+
+				// Options follow the name, i.e: hosts@ttl=3600:command
+				std::vector<std::string_view> name;
+				mtl::string::split(mode.substr(0, colon), "@", std::back_inserter(name));
+
+				LaunchMode launch{name[0], mode.substr(colon + 1)};
+				for (size_t x{1}; x < name.size(); ++x)
+				{
+					constexpr std::string_view TTL{"ttl="};
+					if (name[x] == "persist")
+					{
+						launch.persist = true;
+					}
+					else if (name[x].starts_with(TTL))
+					{
+						uint32_t seconds{};
+						if (std::from_chars(name[x].data() + TTL.size(), name[x].data() + name[x].size(), seconds).ec == std::errc{})
+						{
+							launch.ttl = std::chrono::seconds{seconds};
+						}
+					}
+				}
+
+				return launch;
 			});
 			break;
 		}
@@ -123,79 +236,270 @@ LaunchOptions parse_args(int argc, char **argv)
 			help();
 			break;
 		}
+		case Option::trace:
+		{
+			launch.trace = optarg;
+			break;
+		}
+		case Option::stats:
+		{
+			launch.stats = optarg ? optarg : "";
+			break;
+		}
+		case Option::filter:
+		{
+			launch.filter = optarg;
+			break;
+		}
+		case Option::record:
+		{
+			launch.record = optarg;
+			break;
+		}
+		case Option::replay:
+		{
+			launch.replay = optarg;
+			break;
+		}
+		case Option::threads:
+		{
+			const std::string_view threads{optarg};
+			if (std::from_chars(threads.data(), threads.data() + threads.size(), launch.threads).ec != std::errc{} || launch.threads == 0)
+			{
+				help();
+			}
+
+			break;
+		}
+		case Option::compact:
+		{
+			launch.compact = true;
+			break;
+		}
 		}
 	}
 
 	return launch;
 }
 
+/**
+ * @brief Ranks stdin the same way the results list would and prints the matches
+ * 
+ * @param query What to match
+ * @return int 0 if anything matched, 1 otherwise (same as grep)
+ */
+int filter(const std::string &query)
+{
+	const yaltl::Entries lines{yaltl::modes::load_stdin()};
+
+	std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+	size_t exact{};
+	const std::vector<yaltl::FuzzyResult> ranked{yaltl::matcher::rank(std::begin(lines), std::end(lines), yaltl::utf8::widen(query), false, exact)};
+
+	// Only written out when the buffer fills, even when stdout is a terminal
+	static char buffer[1 << 16];
+	setvbuf(stdout, buffer, _IOFBF, sizeof(buffer));
+
+	std::string line;
+	for (const yaltl::FuzzyResult &result : ranked)
+	{
+		line = converter.to_bytes(result.result->display);
+		line += '\n';
+		fwrite(line.data(), 1, line.size(), stdout);
+	}
+
+	fflush(stdout);
+
+	return ranked.empty() ? 1 : 0;
+}
+
+/**
+ * @brief Gets what builds a mode
+ * 
+ * @param mode The mode from the command line
+ * @return yaltl::modes::lazy::Factory Builds the mode, empty if there's no such mode
+ */
+yaltl::modes::lazy::Factory mode_factory(const LaunchMode &mode)
+{
+	if (mode.script.has_value())
+	{
+#ifdef COPROCESS_FOUND
+		if (mode.persist)
+		{
+			return [mode] { return std::make_unique<yaltl::modes::coprocess>(mode.mode, mode.script.value()); };
+		}
+#endif
+
+		return [mode] { return std::make_unique<yaltl::modes::script>(mode.mode, mode.script.value(), mode.ttl); };
+	}
+
+#ifdef I3IPC_FOUND
+	if ("i3wm" == mode.mode)
+	{
+		return [] { return std::make_unique<yaltl::modes::i3wm>("yaltl"); };
+	}
+#endif
+
+	if ("run" == mode.mode)
+	{
+		return [] { return std::make_unique<yaltl::modes::run>(); };
+	}
+
+#ifdef DRUN_FOUND
+	if ("drun" == mode.mode)
+	{
+		return [] { return std::make_unique<yaltl::modes::drun>(); };
+	}
+#endif
+
+#ifdef RECENT_FOUND
+	if ("recent" == mode.mode)
+	{
+		return [] { return std::make_unique<yaltl::modes::recent>(); };
+	}
+#endif
+
+	return nullptr;
+}
+
+//! Uses the active wal theme if there is one, its escape sequences are written straight to the terminal
+void apply_wal_theme()
+{
+	const char *home{std::getenv("HOME")};
+	if (!home)
+	{
+		return;
+	}
+
+	std::ifstream file{std::filesystem::path{home} / ".cache/wal/sequences", std::ios::binary};
+	const std::string sequences{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+	if (!sequences.empty())
+	{
+		std::cout.write(sequences.data(), sequences.size()) << std::flush;
+	}
+}
+
 int main(int argc, char **argv)
 {
+	const yaltl::trace::Clock::time_point launched{yaltl::trace::Clock::now()};
 	LaunchOptions options{parse_args(argc, argv)};
+	if (options.trace.has_value())
+	{
+		if (!yaltl::trace::start(options.trace.value(), launched))
+		{
+			std::cerr << "yaltl: can't write trace to " << options.trace.value() << std::endl;
+		}
+
+		yaltl::trace::complete("parse_args", launched, yaltl::trace::Clock::now());
+	}
+
+	yaltl::executor::configure(options.threads);
+
+	if (options.stats.has_value() && !yaltl::stats::start(options.stats.value()))
+	{
+		std::cerr << "yaltl: can't write stats to " << options.stats.value() << std::endl;
+	}
+
+	// Never touches the tty, so it works in scripts and pipelines
+	if (options.filter.has_value())
+	{
+		if (!options.dmenu)
+		{
+			help();
+		}
+
+		const int code{filter(options.filter.value())};
+		yaltl::trace::stop();
+		yaltl::stats::stop();
+		return code;
+	}
 
 	yaltl::Modes modes;
+	std::vector<yaltl::modes::lazy *> deferred;
+	std::optional<yaltl::trace::Span> span{std::in_place, "modes"};
 
 	// If we're in dmenu mode, other modes might break, so... just dmenu
 	if (options.dmenu)
 	{
-		modes.emplace_back(std::make_unique<yaltl::modes::dmenu>());
+		modes.emplace_back(std::make_unique<yaltl::modes::dmenu>(options.compact));
 	}
 	else
 	{
-		std::transform(std::begin(options.modes), std::end(options.modes), std::back_inserter(modes), [](const LaunchMode &mode) -> std::unique_ptr<yaltl::Mode> {
-			if (mode.script.has_value())
-			{
-				return std::make_unique<yaltl::modes::script>(mode.mode, mode.script.value());
-			}
-
-#ifdef I3IPC_FOUND
-			if ("i3wm" == mode.mode)
-			{
-				return std::make_unique<yaltl::modes::i3wm>("yaltl");
-			}
-#endif
-
-			if ("run" == mode.mode)
-			{
-				return std::make_unique<yaltl::modes::run>();
-			}
-
-#ifdef GIOMM_FOUND
-			if ("drun" == mode.mode)
+		// Only the first mode is built before the first frame, the rest once it's drawn or they're switched to
+		std::optional<size_t> combined;
+		for (const LaunchMode &mode : options.modes)
+		{
+			if ("combi" == mode.mode && !mode.script.has_value())
 			{
-				return std::make_unique<yaltl::modes::drun>();
+				combined = modes.size();
 			}
-#endif
-
-#ifdef GTKMM_FOUND
-			if ("recent" == mode.mode)
+			else if (yaltl::modes::lazy::Factory factory{mode_factory(mode)})
 			{
-				return std::make_unique<yaltl::modes::recent>();
+				modes.emplace_back(std::make_unique<yaltl::modes::lazy>(std::move(factory)));
+				deferred.push_back(static_cast<yaltl::modes::lazy *>(modes.back().get()));
 			}
-#endif
+		}
 
-			return nullptr;
-		});
+		// Combines every other mode, so it takes its place in the list once they're all there
+		if (combined.has_value() && !modes.empty())
+		{
+			std::vector<yaltl::Mode *> parts;
+			std::transform(std::begin(modes), std::end(modes), std::back_inserter(parts), [](const std::unique_ptr<yaltl::Mode> &mode) { return mode.get(); });
+			modes.insert(std::begin(modes) + combined.value(), std::make_unique<yaltl::modes::combi>(std::move(parts)));
+		}
 	}
 
-	modes.erase(std::remove(std::begin(modes), std::end(modes), nullptr), std::end(modes));
 	if (modes.empty())
 	{
 		// We don't have any modes, so show user help.
 		help();
 	}
 
-	// Use active wal theme if available
-	system("[ -f $HOME/.cache/wal/sequences ] && cat $HOME/.cache/wal/sequences");
+	// Headless, the keys come from the file and frames are drawn to a virtual terminal
+	if (options.replay.has_value())
+	{
+		yaltl::Yaltl yaltl{std::move(modes), [] {}};
+		yaltl.on_exit = [](int) {};
 
-	yaltl::Yaltl yaltl{std::move(modes)};
-	int exit{};
+		const int code{yaltl::session::replay(yaltl, options.replay.value(), std::cout)};
+		yaltl::trace::stop();
+		yaltl::stats::stop();
+		return code;
+	}
+
+	span.emplace("wal sequences");
+	apply_wal_theme();
+
+	span.emplace("ScreenInteractive");
 	auto screen = ftxui::ScreenInteractive::TerminalOutput();
+	yaltl::Yaltl yaltl{std::move(modes), [&screen] {
+		screen.PostEvent(ftxui::Event::Custom);
+	}};
+	span.reset();
+
+	// Yaltl built the first mode, the rest are built in the background once the first frame is up
+	yaltl::executor::Job preparing;
+	yaltl.on_first_frame = [&preparing, deferred] {
+		preparing = yaltl::executor::submit(yaltl::executor::Lane::Background, [deferred](std::stop_token stop) { yaltl::modes::prepare(deferred, stop); });
+	};
+
+	int exit{};
 	yaltl.on_exit = [&exit, &screen](int code) {
 		exit = code;
 		screen.ExitLoopClosure()();
 	};
 
-	screen.Loop(&yaltl);
+	std::optional<yaltl::session::Recorder> recorder;
+	if (options.record.has_value())
+	{
+		if (!recorder.emplace(yaltl, options.record.value()).Recording())
+		{
+			std::cerr << "yaltl: can't record to " << options.record.value() << std::endl;
+		}
+	}
+
+	screen.Loop(recorder.has_value() ? static_cast<ftxui::Component *>(&recorder.value()) : &yaltl);
+	yaltl::trace::stop();
+	yaltl::stats::stop();
 	return exit;
 }
@@ -0,0 +1,44 @@
+#include "modes/combi.h"
+
+#include <algorithm>
+
+namespace yaltl
+{
+    namespace modes
+    {
+        combi::combi(std::vector<Mode *> modes) : m_modes(std::move(modes))
+        {
+        }
+
+        bool combi::Loading() const
+        {
+            return std::any_of(std::begin(m_modes), std::end(m_modes), [](const Mode *mode) { return mode->Loading(); });
+        }
+
+        bool combi::HasPreview() const
+        {
+            return std::any_of(std::begin(m_modes), std::end(m_modes), [](const Mode *mode) { return mode->HasPreview(); });
+        }
+
+        void combi::Search(const std::wstring &text)
+        {
+            for (Mode *mode : m_modes)
+            {
+                mode->Search(text);
+            }
+        }
+
+        std::optional<PostExec> combi::Finished()
+        {
+            for (Mode *mode : m_modes)
+            {
+                if (std::optional<PostExec> finished{mode->Finished()}; finished.has_value())
+                {
+                    return finished;
+                }
+            }
+
+            return std::nullopt;
+        }
+    } // namespace modes
+} // namespace yaltl
@@ -0,0 +1,347 @@
+#include "modes/coprocess.h"
+
+#include "utils/json.h"
+#include "utils/trace.h"
+#include "utils/utf8.h"
+
+#include <cerrno>
+#include <chrono>
+#include <codecvt>
+#include <csignal>
+#include <locale>
+#include <sstream>
+
+#include <poll.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+//! How often the reader checks if it should stop
+constexpr int COPROCESS_POLL_MS{50};
+
+//! Most bytes queued for a script that isn't reading, messages past this are dropped whole
+constexpr size_t COPROCESS_OUTBOX_LIMIT{1 << 20};
+
+//! How long the script gets to exit on its own once its stdin is closed, and again after SIGTERM
+constexpr std::chrono::milliseconds COPROCESS_EXIT_TIMEOUT{200};
+
+namespace yaltl
+{
+    namespace modes
+    {
+        /**
+         * @brief Waits for the process to exit
+         *
+         * @param pid The process to wait on
+         * @param timeout How long to wait
+         * @return true - The process exited and was reaped
+         */
+        static bool wait_exit(pid_t pid, std::chrono::milliseconds timeout)
+        {
+            const auto deadline{std::chrono::steady_clock::now() + timeout};
+            int status{};
+            while (0 == waitpid(pid, &status, WNOHANG))
+            {
+                if (std::chrono::steady_clock::now() >= deadline)
+                {
+                    return false;
+                }
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+
+            return true;
+        }
+
+        coprocess::coprocess(std::string_view name, std::string_view command) : m_name(utf8::widen(name))
+        {
+            trace::Span span{"coprocess::coprocess"};
+
+            // A socket instead of pipes so writes to a script that died fail with EPIPE instead of raising SIGPIPE
+            int fds[2]{};
+            if (0 != socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds))
+            {
+                m_exited = true;
+                m_waiting = false;
+                return;
+            }
+
+            posix_spawn_file_actions_t actions;
+            posix_spawn_file_actions_init(&actions);
+            posix_spawn_file_actions_adddup2(&actions, fds[1], STDIN_FILENO);
+            posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+
+            // Its own process group, so anything the script starts can be stopped with it
+            posix_spawnattr_t attributes;
+            posix_spawnattr_init(&attributes);
+            posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP);
+            posix_spawnattr_setpgroup(&attributes, 0);
+
+            std::string shellCommand{command};
+            char *argv[]{const_cast<char *>("sh"), const_cast<char *>("-c"), shellCommand.data(), nullptr};
+            const int error{posix_spawn(&m_pid, "/bin/sh", &actions, &attributes, argv, environ)};
+
+            posix_spawnattr_destroy(&attributes);
+            posix_spawn_file_actions_destroy(&actions);
+            close(fds[1]);
+
+            if (0 != error)
+            {
+                close(fds[0]);
+                m_pid = -1;
+                m_exited = true;
+                m_waiting = false;
+                return;
+            }
+
+            m_socket = fds[0];
+            m_reader = std::jthread{[this](std::stop_token stop) { Read(stop); }};
+        }
+
+        coprocess::~coprocess()
+        {
+            if (m_reader.joinable())
+            {
+                m_reader.request_stop();
+                m_reader.join();
+            }
+
+            if (m_socket >= 0)
+            {
+                close(m_socket);
+            }
+
+            // Closing the socket is the script's cue to exit, only force it if it doesn't
+            if (m_pid > 0 && !wait_exit(m_pid, COPROCESS_EXIT_TIMEOUT))
+            {
+                kill(-m_pid, SIGTERM);
+                if (!wait_exit(m_pid, COPROCESS_EXIT_TIMEOUT))
+                {
+                    kill(-m_pid, SIGKILL);
+                    waitpid(m_pid, nullptr, 0);
+                }
+            }
+        }
+
+        void coprocess::Read(std::stop_token stop)
+        {
+            pollfd fd{m_socket, POLLIN, 0};
+            std::string buffer;
+            char chunk[4096];
+            bool open{true};
+            while (open && !stop.stop_requested())
+            {
+                // Also wait on the script to make room for what Send couldn't write
+                {
+                    std::scoped_lock lock{m_outboxLock};
+                    fd.events = m_outbox.empty() ? POLLIN : POLLIN | POLLOUT;
+                }
+
+                const int ready{poll(&fd, 1, COPROCESS_POLL_MS)};
+                if (ready < 0 && errno != EINTR)
+                {
+                    break;
+                }
+
+                if (ready <= 0)
+                {
+                    continue;
+                }
+
+                if (fd.revents & POLLOUT)
+                {
+                    std::scoped_lock lock{m_outboxLock};
+                    Flush();
+                }
+
+                if (!(fd.revents & (POLLIN | POLLHUP | POLLERR)))
+                {
+                    continue;
+                }
+
+                const ssize_t count{recv(m_socket, chunk, sizeof(chunk), MSG_DONTWAIT)};
+                if (count < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK))
+                {
+                    continue;
+                }
+
+                if (count <= 0)
+                {
+                    open = false;
+                    break;
+                }
+
+                buffer.append(chunk, static_cast<size_t>(count));
+                size_t start{};
+                for (size_t end{buffer.find('\n')}; end != std::string::npos; end = buffer.find('\n', start))
+                {
+                    Handle(std::string_view{buffer}.substr(start, end - start));
+                    start = end + 1;
+                }
+
+                buffer.erase(0, start);
+            }
+
+            if (!open)
+            {
+                m_exited = true;
+                m_waiting = false;
+                m_batches.Finish();
+                Notify();
+            }
+        }
+
+        void coprocess::Handle(std::string_view line)
+        {
+            // Bad output shouldn't take the reader down with it, bytes that aren't UTF-8 are replaced on their own
+            json::Scanner scanner{line};
+            auto strings{[&scanner](Entries &entries) {
+                return scanner.Array([&scanner, &entries] {
+                    std::string text;
+                    if (!scanner.String(text))
+                    {
+                        return false;
+                    }
+
+                    entries.push_back(std::make_shared<Entry>(utf8::widen(text)));
+                    return true;
+                });
+            }};
+
+            std::optional<Entries> replace;
+            Entries append;
+            bool close{};
+            const bool parsed{scanner.Object([&](std::string_view key) {
+                if (key == "replace")
+                {
+                    return strings(replace.emplace());
+                }
+
+                if (key == "append")
+                {
+                    return strings(append);
+                }
+
+                if (key == "close")
+                {
+                    return scanner.Bool(close);
+                }
+
+                return scanner.Skip();
+            })};
+
+            if (!parsed)
+            {
+                return;
+            }
+
+            if (replace.has_value())
+            {
+                m_batches.Replace(std::move(replace.value()));
+            }
+
+            if (!append.empty())
+            {
+                m_batches.Append(std::move(append));
+            }
+
+            m_close = m_close || close;
+            m_waiting = false;
+            Notify();
+        }
+
+        bool coprocess::Send(std::string message)
+        {
+            if (m_socket < 0)
+            {
+                return false;
+            }
+
+            message += '\n';
+            std::scoped_lock lock{m_outboxLock};
+
+            // Never blocks the UI, a script that stopped reading misses out on whole messages rather than getting part of one
+            if (!m_outbox.empty() && m_outbox.size() + message.size() > COPROCESS_OUTBOX_LIMIT)
+            {
+                return false;
+            }
+
+            m_outbox += message;
+            return Flush();
+        }
+
+        bool coprocess::Flush()
+        {
+            size_t sent{};
+            while (sent < m_outbox.size())
+            {
+                const ssize_t count{send(m_socket, m_outbox.data() + sent, m_outbox.size() - sent, MSG_NOSIGNAL | MSG_DONTWAIT)};
+                if (count < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+
+                // The rest goes once the reader sees the script made room
+                if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                {
+                    break;
+                }
+
+                if (count <= 0)
+                {
+                    m_outbox.clear();
+                    return false;
+                }
+
+                sent += static_cast<size_t>(count);
+            }
+
+            m_outbox.erase(0, sent);
+            return true;
+        }
+
+        const Entries &coprocess::Results()
+        {
+            m_batches.Drain(m_results);
+
+            return m_results;
+        }
+
+        void coprocess::Search(const std::wstring &text)
+        {
+            std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+            std::ostringstream message;
+            message << R"({"event":"query","text":)" << json::quote(converter.to_bytes(text)) << "}";
+
+            Send(message.str());
+        }
+
+        std::optional<PostExec> coprocess::Finished()
+        {
+            // A script that exits after a result was picked is done as well
+            if (m_close || (m_executed && m_exited))
+            {
+                return PostExec::CloseSuccess;
+            }
+
+            return std::nullopt;
+        }
+
+        PostExec coprocess::Execute(const Entry &result, const std::wstring &text)
+        {
+            std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+            std::ostringstream message;
+            message << R"({"event":"select","text":)" << json::quote(converter.to_bytes(result.display))
+                    << R"(,"query":)" << json::quote(converter.to_bytes(text)) << "}";
+
+            m_executed = true;
+            m_waiting = true;
+
+            // The script answers in its own time, Finished closes yaltl if it asks to
+            return Send(message.str()) ? PostExec::StayOpen : PostExec::CloseFailure;
+        }
+    } // namespace modes
+} // namespace yaltl
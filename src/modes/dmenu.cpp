@@ -1,14 +1,15 @@
 #include "modes/dmenu.h"
 
-#include "utils/popen.h"
+#include "utils/file.h"
+#include "utils/trace.h"
+#include "utils/utf8.h"
 
 #include <mtl/string.hpp>
 
 #include <algorithm>
 #include <cstdio>
-#include <codecvt>
 #include <iostream>
-#include <locale>
+#include <string>
 
 #ifdef WIN32
 #include <io.h>
@@ -23,17 +24,19 @@ constexpr auto CONSOLE_OUTPUT = "/dev/tty";
 #include <unistd.h>
 #endif
 
+//! Fewest lines worth indexing, scanning fewer takes about as long as a frame
+constexpr size_t MIN_INDEXED_ENTRIES{100'000};
+
+//! Most bytes the index may take, larger inputs are scanned instead
+constexpr size_t INDEX_BUDGET{256 << 20};
+
 namespace yaltl
 {
     namespace modes
     {
-        /**
-         * @brief Loads all lines from stdin
-         * 
-         * @return std::vector<std::wstring> The lines read from stdin
-         */
         Entries load_stdin()
         {
+            trace::Span span{"dmenu::load_stdin"};
             std::vector<char> buffer;
             char buff[1024]{};
             for (size_t size{fread(buff, 1, sizeof(buff), stdin)}; size > 0; size = fread(buff, 1, sizeof(buff), stdin))
@@ -49,19 +52,59 @@ namespace yaltl
 
             Entries lines;
             lines.reserve(rawLines.size());
-            std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-            std::transform(std::begin(rawLines), std::end(rawLines), std::back_inserter(lines), [&converter](std::string_view line) {
-                return std::make_shared<Entry>(converter.from_bytes(line.data(), line.data() + line.size()));
+            std::transform(std::begin(rawLines), std::end(rawLines), std::back_inserter(lines), [](std::string_view line) {
+                return std::make_shared<Entry>(utf8::widen(line));
             });
 
             return lines;
         }
 
-        dmenu::dmenu() : m_entries(load_stdin()),                       // Load stdin before re-routing I/O
-                         m_stdoutCopy{dup(STDOUT_FILENO)},              // Save off stdout, this is what gets piped to the next process
-                         m_stdinCopy{dup(STDIN_FILENO)},                // Save off stdin, probably not important...
-                         m_ttyIn{freopen(CONSOLE_INPUT, "r", stdin)},   // Open up the tty for input (otherwise the user can't interact with yaltl)
-                         m_ttyOut{freopen(CONSOLE_OUTPUT, "w", stdout)} // Open up the tty for output (otherwise yaltl won't render).
+        FrontCoded load_stdin_store()
+        {
+            trace::Span span{"dmenu::load_stdin_store"};
+            FrontCoded lines;
+            std::vector<char> buffer(1 << 16);
+            std::string partial;
+            for (size_t size{fread(buffer.data(), 1, buffer.size(), stdin)}; size > 0; size = fread(buffer.data(), 1, buffer.size(), stdin))
+            {
+                std::string_view chunk{buffer.data(), size};
+                for (size_t end{chunk.find('\n')}; end != std::string_view::npos; end = chunk.find('\n'))
+                {
+                    // Lines split between reads are put back together first
+                    if (partial.empty())
+                    {
+                        lines.Append(chunk.substr(0, end));
+                    }
+                    else
+                    {
+                        partial.append(chunk.substr(0, end));
+                        lines.Append(partial);
+                        partial.clear();
+                    }
+
+                    chunk.remove_prefix(end + 1);
+                }
+
+                partial.append(chunk);
+            }
+
+            // The last line doesn't need a newline after it
+            if (!partial.empty())
+            {
+                lines.Append(partial);
+            }
+
+            lines.Shrink();
+            return lines;
+        }
+
+        dmenu::dmenu(bool compact) : m_compact{compact},
+                                     m_entries(compact ? Entries{} : load_stdin()),         // Load stdin before re-routing I/O
+                                     m_store(compact ? load_stdin_store() : FrontCoded{}),  // Or into the compact store
+                                     m_stdoutCopy{dup(STDOUT_FILENO)},                      // Save off stdout, this is what gets piped to the next process
+                                     m_stdinCopy{dup(STDIN_FILENO)},                        // Save off stdin, probably not important...
+                                     m_ttyIn{freopen(CONSOLE_INPUT, "r", stdin)},           // Open up the tty for input (otherwise the user can't interact with yaltl)
+                                     m_ttyOut{freopen(CONSOLE_OUTPUT, "w", stdout)}         // Open up the tty for output (otherwise yaltl won't render).
         {
 #ifdef WIN32
             std::ios::sync_with_stdio(true);
@@ -73,6 +116,35 @@ namespace yaltl
             setvbuf(stdout, nullptr, _IONBF, 0);
             setvbuf(stdin, nullptr, _IONBF, 0);
 #endif
+
+            // Searches scan everything until the index is ready
+            if (m_entries.size() + m_store.Size() >= MIN_INDEXED_ENTRIES)
+            {
+                m_indexing = executor::submit(executor::Lane::Background, [this](std::stop_token stop) {
+                    trace::Span span{"dmenu::index"};
+                    std::optional<CharIndex> index{m_compact ? CharIndex::build(m_store, INDEX_BUDGET, stop) : CharIndex::build(m_entries, INDEX_BUDGET, stop)};
+                    if (!index.has_value())
+                    {
+                        trace::mark("dmenu::index skipped, over " + std::to_string(INDEX_BUDGET) + " bytes or stopped");
+                        return;
+                    }
+
+                    trace::mark("dmenu::index " + std::to_string(index->Size()) + " entries in " + std::to_string(index->Bytes()) + " bytes");
+                    std::scoped_lock lock{m_indexLock};
+                    m_index = std::make_shared<const CharIndex>(std::move(index.value()));
+                });
+            }
+        }
+
+        std::optional<std::vector<uint32_t>> dmenu::Candidates(std::wstring_view search) const
+        {
+            std::shared_ptr<const CharIndex> index;
+            {
+                std::scoped_lock lock{m_indexLock};
+                index = m_index;
+            }
+
+            return index ? index->Candidates(search) : std::nullopt;
         }
 
         dmenu::~dmenu()
@@ -1,9 +1,14 @@
 #include "modes/drun.h"
 #include "utils/command.h"
+#include "utils/desktop.h"
 #include "utils/spawn.h"
+#include "utils/trace.h"
 
-#include <giomm/appinfo.h>
+#ifdef GIOMM_FOUND
+#include <giomm/desktopappinfo.h>
 #include <giomm/init.h>
+#endif
+
 #include <mtl/string.hpp>
 
 #include <algorithm>
@@ -12,78 +17,102 @@
 
 namespace yaltl
 {
-    using AppInfo = Glib::RefPtr<Gio::AppInfo>;
-
     struct AppEntry : public Entry
     {
         using Entry::Entry;
 
-        AppInfo app;
+        desktop::Application app;
     };
 
     namespace modes
     {
-        std::wstring get_app_display(AppInfo &appinfo)
+        std::wstring get_app_display(const desktop::Application &app, std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> &converter)
         {
-            std::string description{appinfo->get_description()};
-            std::string name{appinfo->get_display_name()};
-            name = name.empty() ? appinfo->get_name() : name;
-            std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-
-            return converter.from_bytes(description.empty() ? name : name + ": " + description);
+            return converter.from_bytes(app.description.empty() ? app.display_name : app.display_name + ": " + app.description);
         }
 
-        std::future<Entries> load_apps()
+        /**
+         * @brief Loads the desktop applications, handing out entries as each batch of files is parsed
+         * 
+         * @param batches Where to put the applications as they load
+         * @param notify Called after each batch
+         */
+        void load_apps(Batches &batches, const std::function<void()> &notify)
         {
-            static std::once_flag GIO_INIT_FLAG;
-            std::call_once(GIO_INIT_FLAG, Gio::init);
-
-            return std::async(std::launch::async, [] {
-                auto apps{Gio::AppInfo::get_all()};
-                Entries results(apps.size());
+            trace::Span span{"drun::load_apps"};
+            desktop::load_all([&batches, &notify](std::vector<desktop::Application> &&apps) {
+                apps.erase(std::remove_if(std::begin(apps), std::end(apps), [](const desktop::Application &app) {
+                               return !desktop::should_show(app);
+                           }),
+                           std::end(apps));
+
+                Entries results;
+                results.reserve(apps.size());
                 std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-                std::transform(std::begin(apps), std::end(apps), std::begin(results), [&converter](AppInfo appinfo) {
-                    auto appResult{std::make_shared<AppEntry>(get_app_display(appinfo))};
-                    appResult->app = appinfo;
-                    if (appinfo->should_show())
+                std::transform(std::begin(apps), std::end(apps), std::back_inserter(results), [&converter](desktop::Application &app) {
+                    auto appResult{std::make_shared<AppEntry>(get_app_display(app, converter))};
+                    std::vector<std::wstring> criteria{{
+                        converter.from_bytes(app.name),
+                        converter.from_bytes(app.display_name),
+                    }};
+
+                    if (std::vector<std::string> argv{desktop::expand_exec(app)}; !argv.empty())
                     {
-                        std::vector<std::wstring> criteria{{
-                            converter.from_bytes(appinfo->get_name()),
-                            converter.from_bytes(appinfo->get_display_name()),
-                            converter.from_bytes(appinfo->get_executable()),
-                            converter.from_bytes(commands::parse(appinfo->get_commandline()).path.filename()),
-                        }};
+                        criteria.push_back(converter.from_bytes(argv[0]));
+                        criteria.push_back(converter.from_bytes(std::filesystem::path{argv[0]}.filename().string()));
+                    }
 
-                        std::sort(std::begin(criteria), std::end(criteria), mtl::string::iless<wchar_t>{});
-                        criteria.erase(std::unique(std::begin(criteria), std::end(criteria), mtl::string::iequals<wchar_t>{}), std::end(criteria));
+                    std::sort(std::begin(criteria), std::end(criteria), mtl::string::iless<wchar_t>{});
+                    criteria.erase(std::unique(std::begin(criteria), std::end(criteria), mtl::string::iequals<wchar_t>{}), std::end(criteria));
 
-                        appResult->criteria.emplace(std::move(criteria));
-                    }
+                    appResult->criteria.emplace(std::move(criteria));
+                    appResult->app = std::move(app);
 
                     return appResult;
                 });
 
-                results.erase(std::remove_if(std::begin(results), std::end(results), [](std::shared_ptr<Entry> res) {
-                                  auto ptr{reinterpret_cast<AppEntry *>(res.get())};
-                                  return !ptr->app->should_show();
-                              }),
-                              std::end(results));
-
-                return results;
+                if (!results.empty())
+                {
+                    batches.Append(std::move(results));
+                    notify();
+                }
             });
+
+            batches.Finish();
+            notify();
         }
 
-        drun::drun() : m_loading{load_apps()}
+#ifdef GIOMM_FOUND
+        /**
+         * @brief Lets GIO launch the application, for entries we can't launch ourselves (i.e: DBusActivatable)
+         * 
+         * @param app The application to launch
+         * @return true - GIO launched the application
+         */
+        bool launch_with_gio(const desktop::Application &app)
+        {
+            static std::once_flag GIO_INIT_FLAG;
+            std::call_once(GIO_INIT_FLAG, Gio::init);
+
+            try
+            {
+                Glib::RefPtr<Gio::DesktopAppInfo> info{Gio::DesktopAppInfo::create_from_filename(app.path.string())};
+                return info && info->launch(std::vector<Glib::RefPtr<Gio::File>>{});
+            }
+            catch (const Glib::Error &)
+            {
+                return false;
+            }
+        }
+#endif
+
+        drun::drun() : m_loading{executor::submit(executor::Lane::Background, [this](std::stop_token) { load_apps(m_batches, [this] { Notify(); }); })}
         {
         }
 
         const Entries &drun::Results()
         {
-            // Get results from launch, be willing to wait
-            if (m_entries.empty() && m_loading.valid())
-            {
-                m_entries = m_loading.get();
-            }
+            m_batches.Drain(m_entries);
 
             return m_entries;
         }
@@ -91,14 +120,23 @@ namespace yaltl
         PostExec drun::Execute(const Entry &result, const std::wstring &)
         {
             const AppEntry *appResult = reinterpret_cast<const AppEntry *>(&result);
-            auto &info{appResult->app};
-            std::string full_command{info->get_commandline()};
-
-            // Remove special placeholders for AppInfo entry
-            mtl::string::ierase_all(full_command, "%u");
-            mtl::string::ierase_all(full_command, "%f");
+            std::vector<std::string> argv{desktop::expand_exec(appResult->app)};
+            if (!argv.empty())
+            {
+                Command command;
+                command.path = argv[0];
+                command.argv = std::move(argv);
+                if (spawn(std::move(command)))
+                {
+                    return PostExec::CloseSuccess;
+                }
+            }
 
-            return spawn(commands::parse(full_command)) ? PostExec::CloseSuccess : PostExec::CloseFailure;
+#ifdef GIOMM_FOUND
+            return launch_with_gio(appResult->app) ? PostExec::CloseSuccess : PostExec::CloseFailure;
+#else
+            return PostExec::CloseFailure;
+#endif
         }
     } // namespace modes
 
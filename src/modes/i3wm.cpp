@@ -1,97 +1,169 @@
 #include "modes/i3wm.h"
 
-#include <i3ipc++/log.hpp>
+#include "utils/json.h"
+#include "utils/trace.h"
 
 #include <codecvt>
 #include <locale>
 #include <sstream>
+#include <unordered_map>
 
-#define APP_ID "app_id"
-#define INSTANCE_ID "instance"
+#include <poll.h>
+
+//! How often the event thread checks if it should stop
+constexpr int EVENT_POLL_MS{100};
 
 namespace yaltl
 {
     namespace modes
     {
-        using con_t = std::shared_ptr<i3ipc::container_t>;
+        using Window = i3wm::Window;
 
         struct ContainerEntry : public Entry
         {
             using Entry::Entry;
 
-            con_t container;
+            Window window;
         };
 
         namespace tree
         {
             /**
-             * @brief Check if the container is to be ignored
+             * @brief Check if the window is to be ignored
              * 
-             * @param con The container to check
+             * @param window The window to check
              * @return true - Ignore it
              * @return false - Don't ignore it
              */
-            static bool ignore_listed(con_t con)
+            static bool ignore_listed(const Window &window)
             {
-                if (!con)
-                {
-                    return true;
-                }
-
                 static const char *IGNORE_LIST[] = {
                     "polybar",
                 };
 
-                const std::string &winclass{con->app_id.value_or(con->window_properties.instance)};
-                return std::any_of(std::begin(IGNORE_LIST), std::end(IGNORE_LIST), [&winclass](const char *toIgnore) {
-                    return winclass == toIgnore;
+                return std::any_of(std::begin(IGNORE_LIST), std::end(IGNORE_LIST), [&window](const char *toIgnore) {
+                    return window.app_id == toIgnore;
                 });
             }
 
             /**
-             * @brief Gets all windows from the tree
+             * @brief Reads a container in a single pass, pulling out only the fields we need.
              * 
-             * @param con The current spot in the tree
-             * @param wins [Out] the windows collected
+             * @param scanner Positioned at the container object
+             * @param wins [Out] Windows found in the container, including itself, in tree order
              * @param self An identifier for self to ignore
+             * @param con [Out] The container itself
+             * @param isWindow [Out] If the container is a window we should list
+             * @return true - The container was read
              */
-            static void windows(con_t con, std::vector<con_t> &wins, const std::string &self)
+            static bool container(json::Scanner &scanner, std::vector<Window> &wins, const std::string &self, Window &con, bool &isWindow)
             {
-                if (!con)
-                {
-                    return;
-                }
-
-                const bool isSelf{(con->app_id.value_or(con->window_properties.instance) == self)};
-                if (!isSelf && !ignore_listed(con) && con->nodes.empty() && con->floating_nodes.empty() && (con->type == "con" || con->type == "floating_con"))
+                std::string type;
+                std::string instance;
+                std::optional<std::string> appId;
+                bool hasChildren{};
+                auto children{[&scanner, &wins, &self, &hasChildren] {
+                    return scanner.Array([&scanner, &wins, &self, &hasChildren] {
+                        hasChildren = true;
+
+                        Window node;
+                        bool nodeIsWindow{};
+                        return container(scanner, wins, self, node, nodeIsWindow);
+                    });
+                }};
+
+                const bool parsed{scanner.Object([&](std::string_view key) {
+                    if (key == "id")
+                    {
+                        return scanner.Number(con.id);
+                    }
+
+                    if (key == "name")
+                    {
+                        return scanner.Null() || scanner.String(con.name);
+                    }
+
+                    if (key == "type")
+                    {
+                        return scanner.String(type);
+                    }
+
+                    if (key == "app_id")
+                    {
+                        return scanner.Null() || scanner.String(appId.emplace());
+                    }
+
+                    if (key == "window_properties")
+                    {
+                        return scanner.Object([&scanner, &instance](std::string_view property) {
+                            return property == "instance" ? scanner.Null() || scanner.String(instance) : scanner.Skip();
+                        });
+                    }
+
+                    if (key == "nodes" || key == "floating_nodes")
+                    {
+                        return children();
+                    }
+
+                    return scanner.Skip();
+                })};
+
+                // Sway has app_id for wayland windows, X11 windows only have the instance
+                con.app_id = appId.value_or(instance);
+                isWindow = parsed && !hasChildren && (type == "con" || type == "floating_con") && con.app_id != self && !ignore_listed(con);
+                if (isWindow)
                 {
                     wins.push_back(con);
                 }
 
-                for (auto &node : con->nodes)
-                {
-                    windows(node, wins, self);
-                }
+                return parsed;
+            }
 
-                for (auto &node : con->floating_nodes)
-                {
-                    windows(node, wins, self);
-                }
+            std::vector<Window> windows(std::string_view tree, const std::string &self)
+            {
+                std::vector<Window> wins;
+                json::Scanner scanner{tree};
+                Window root;
+                bool isWindow{};
+                container(scanner, wins, self, root, isWindow);
+
+                return wins;
+            }
+
+            bool window_event(std::string_view payload, const std::string &self, std::string &change, Window &con, bool &isWindow)
+            {
+                std::vector<Window> ignored;
+                json::Scanner scanner{payload};
+                return scanner.Object([&](std::string_view key) {
+                    if (key == "change")
+                    {
+                        return scanner.String(change);
+                    }
+
+                    if (key == "container")
+                    {
+                        return container(scanner, ignored, self, con, isWindow);
+                    }
+
+                    return scanner.Skip();
+                });
             }
 
             /**
-             * @brief Get all the windows in the tree
+             * @brief Reads what changed from an event
              * 
-             * @param tree the tree
-             * @param self Identifier for self to avoid
-             * @return std::vector<con_t> 
+             * @param payload The event payload
+             * @return std::string The change, i.e: reload
              */
-            static std::vector<con_t> windows(con_t tree, const std::string &self)
+            static std::string change(std::string_view payload)
             {
-                std::vector<con_t> wins;
-                windows(tree, wins, self);
+                std::string change;
+                json::Scanner scanner{payload};
+                scanner.Object([&scanner, &change](std::string_view key) {
+                    return key == "change" ? scanner.String(change) : scanner.Skip();
+                });
 
-                return wins;
+                return change;
             }
         } // namespace tree
 
@@ -112,85 +184,204 @@ namespace yaltl
             }
 
             /**
-             * @brief Get the instance string since it's different between sway and i3
+             * @brief Gets a command to focus on a container.
              * 
-             * @return const char* 
-             */
-            const char *get_instance_string()
-            {
-                static const char *instance{std::string(std::getenv("I3SOCK")).find("sway") != std::string::npos ? APP_ID : INSTANCE_ID};
-                return instance;
-            }
-
-            /**
-             * @brief Gets the command to move a window using instance/app_id
+             * Matching on con_id is exact and constant time for the compositor, unlike title regexes.
              * 
-             * @param window_id The window to move
-             * @param workspace The workspace to move to
-             * @return std::string
+             * @param window The window to focus on
+             * @return std::string 
              */
-            std::string move_instance(const std::string &window_id, const std::string &workspace)
+            std::string focus_window(const Window &window)
             {
                 std::ostringstream command;
-                command << "[" << get_instance_string() << "=\"" << window_id << "\"] move to workspace " << workspace;
+                command << "[con_id=" << window.id << "] focus";
 
                 return command.str();
             }
+        } // namespace commands
 
-            /**
-             * @brief Gets the command to focus on a window using instance/app_id
-             * 
-             * @param window_id The window to focus
-             * @return std::string 
-             */
-            std::string focus_instance(const std::string &window_id)
-            {
-                std::ostringstream command;
-                command << "[" << get_instance_string() << "=\"" << window_id << "\"] focus";
+        i3wm::i3wm(std::string &&self_id) : m_self_id(std::move(self_id))
+        {
+            m_watcher = std::jthread{[this](std::stop_token stop) { WatchEvents(stop); }};
+        }
 
-                return command.str();
+        void i3wm::WatchEvents(std::stop_token stop)
+        {
+            auto update{[this](auto &&change) {
+                bool changed{};
+                {
+                    std::scoped_lock lock{m_windowsLock};
+                    changed = change(m_windows);
+                    m_dirty = m_dirty || changed;
+                }
+
+                if (changed)
+                {
+                    Notify();
+                }
+            }};
+
+            auto same{[](const std::vector<Window> &lhs, const std::vector<Window> &rhs) {
+                return std::equal(std::begin(lhs), std::end(lhs), std::begin(rhs), std::end(rhs), [](const Window &left, const Window &right) {
+                    return left.id == right.id && left.name == right.name;
+                });
+            }};
+
+            // Events come in on their own connection, trees are read on another so replies never interleave with events
+            i3::Connection events;
+            i3::Connection query;
+
+            // Subscribe before getting the tree so nothing that happens in between is missed
+            if (trace::Span span{"i3wm::WatchEvents initial tree"}; events.Subscribe(R"(["window","workspace"])"))
+            {
+                if (std::optional<std::string> tree{query.Request(i3::Message::GetTree)}; tree.has_value())
+                {
+                    std::vector<Window> initial{tree::windows(tree.value(), m_self_id)};
+                    update([&initial](std::vector<Window> &windows) {
+                        windows = std::move(initial);
+                        return true;
+                    });
+                }
             }
 
-            /**
-             * @brief Gets a command to focus on a container
-             * 
-             * @param con The container to focus on
-             * @return std::string 
-             */
-            std::string focus_window(const i3ipc::container_t &con)
+            m_loaded = true;
+            Notify();
+
+            pollfd fd{events.Fd(), POLLIN, 0};
+            uint32_t type{};
+            std::string payload;
+            while (events.Connected() && !stop.stop_requested())
             {
-                std::ostringstream command;
-                command << "[title=\"" << con.name << "\"] focus";
+                if (poll(&fd, 1, EVENT_POLL_MS) <= 0)
+                {
+                    continue;
+                }
 
-                return command.str();
+                if (!events.Read(type, payload))
+                {
+                    break;
+                }
+
+                if (type == static_cast<uint32_t>(i3::Event::Window))
+                {
+                    std::string change;
+                    Window con;
+                    bool isWindow{};
+                    if (!tree::window_event(payload, m_self_id, change, con, isWindow))
+                    {
+                        continue;
+                    }
+
+                    update([&change, &con, isWindow](std::vector<Window> &windows) {
+                        auto itr{std::find_if(std::begin(windows), std::end(windows), [&con](const Window &window) { return window.id == con.id; })};
+                        if (change == "new")
+                        {
+                            if (itr != std::end(windows) || !isWindow)
+                            {
+                                return false;
+                            }
+
+                            windows.push_back(std::move(con));
+                            return true;
+                        }
+
+                        if (change == "close")
+                        {
+                            if (itr == std::end(windows))
+                            {
+                                return false;
+                            }
+
+                            windows.erase(itr);
+                            return true;
+                        }
+
+                        if (change == "title")
+                        {
+                            if (itr == std::end(windows) || itr->name == con.name)
+                            {
+                                return false;
+                            }
+
+                            itr->name = std::move(con.name);
+                            return true;
+                        }
+
+                        // Focus, moves and such don't change what we list
+                        return false;
+                    });
+                }
+                else if (type == static_cast<uint32_t>(i3::Event::Workspace))
+                {
+                    const std::string change{tree::change(payload)};
+                    if (change != "reload" && change != "restored")
+                    {
+                        continue;
+                    }
+
+                    // The whole layout may have changed, start over from the tree
+                    std::optional<std::string> tree{query.Request(i3::Message::GetTree)};
+                    if (!tree.has_value())
+                    {
+                        continue;
+                    }
+
+                    std::vector<Window> fresh{tree::windows(tree.value(), m_self_id)};
+                    update([&fresh, &same](std::vector<Window> &windows) {
+                        if (same(windows, fresh))
+                        {
+                            return false;
+                        }
+
+                        windows = std::move(fresh);
+                        return true;
+                    });
+                }
             }
-        } // namespace commands
 
-        i3wm::i3wm(std::string &&self_id) : m_self_id(std::move(self_id))
-        {
-            // i3ipc will output to stdout or stderr, so make sure to clear it when not debugging issues.
-            i3ipc::g_logging_outs.clear();
+            m_loaded = true;
+            Notify();
         }
 
         const Entries &i3wm::Results()
         {
-            // Always query for active windows since it can change as we go
-            std::vector<con_t> tree{tree::windows(m_conn.get_tree(), m_self_id)};
-            m_active.resize(tree.size());
+            std::vector<Window> windows;
+            {
+                std::scoped_lock lock{m_windowsLock};
+                if (!m_dirty)
+                {
+                    return m_active;
+                }
+
+                windows = m_windows;
+                m_dirty = false;
+            }
 
+            // Reuse entries for windows that haven't changed
+            std::unordered_map<uint64_t, std::shared_ptr<Entry>> previous;
+            for (std::shared_ptr<Entry> &entry : m_active)
+            {
+                const ContainerEntry *container{reinterpret_cast<const ContainerEntry *>(entry.get())};
+                previous.emplace(container->window.id, std::move(entry));
+            }
+
+            m_active.resize(windows.size());
             std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-            std::transform(std::begin(tree), std::end(tree), std::begin(m_active), [&converter](con_t &con) {
-                auto result{std::make_shared<ContainerEntry>(converter.from_bytes(con->name))};
-                result->container = con;
+            std::transform(std::begin(windows), std::end(windows), std::begin(m_active), [&converter, &previous](Window &window) -> std::shared_ptr<Entry> {
+                if (auto itr{previous.find(window.id)}; itr != std::end(previous) && reinterpret_cast<const ContainerEntry *>(itr->second.get())->window.name == window.name)
+                {
+                    return std::move(itr->second);
+                }
+
+                auto result{std::make_shared<ContainerEntry>(converter.from_bytes(window.name))};
+                result->window = std::move(window);
 
                 return result;
             });
 
-            return m_active;
-        }
+            ++m_generation;
 
-        void i3wm::Preview(const Entry &selected)
-        {
+            return m_active;
         }
 
         /**
@@ -202,9 +393,8 @@ namespace yaltl
         PostExec i3wm::Execute(const Entry &result, const std::wstring &)
         {
             auto res = reinterpret_cast<const ContainerEntry *>(&result);
-            auto con{res->container};
 
-            return m_conn.send_command(commands::focus_window(*con)) ? PostExec::CloseSuccess : PostExec::CloseFailure;
+            return m_conn.Command(commands::focus_window(res->window)) ? PostExec::CloseSuccess : PostExec::CloseFailure;
         }
     } // namespace modes
 
@@ -0,0 +1,38 @@
+#include "modes/lazy.h"
+#include "utils/trace.h"
+
+namespace yaltl
+{
+    namespace modes
+    {
+        lazy::lazy(Factory factory) : m_factory(std::move(factory))
+        {
+        }
+
+        Mode &lazy::Get() const
+        {
+            std::call_once(m_built, [this] {
+                trace::Span span{"lazy::Get"};
+                m_mode = m_factory();
+
+                // const_cast: the mode is built on first use, even through const members
+                m_mode->Subscribe([self{const_cast<lazy *>(this)}] { self->Notify(); });
+            });
+
+            return *m_mode;
+        }
+
+        void prepare(const std::vector<lazy *> &modes, std::stop_token stop)
+        {
+            for (lazy *mode : modes)
+            {
+                if (stop.stop_requested())
+                {
+                    return;
+                }
+
+                mode->Get();
+            }
+        }
+    } // namespace modes
+} // namespace yaltl
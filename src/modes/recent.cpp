@@ -1,13 +1,40 @@
 #include "modes/recent.h"
 
 #include "utils/spawn.h"
+#include "utils/trace.h"
+#include "utils/xml.h"
 
-#include <gtkmm/recentmanager.h>
-#include <gtkmm/main.h>
-
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
 #include <codecvt>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
 #include <locale>
-#include <sstream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//! How long to wait on a mount to answer if its files still exist
+constexpr std::chrono::seconds EXISTS_TIMEOUT{2};
+
+//! How long to wait on a mount when previewing, much shorter since the user is waiting on it
+constexpr std::chrono::milliseconds PREVIEW_TIMEOUT{300};
+
+//! Only the start of a file is read for its preview
+constexpr size_t PREVIEW_BYTES{4096};
+
+//! Most lines to show in a preview
+constexpr size_t PREVIEW_LINES{64};
+
+//! How many rendered previews to keep
+constexpr size_t PREVIEW_CACHE_SIZE{128};
 
 namespace yaltl
 {
@@ -17,57 +44,581 @@ namespace yaltl
 		{
 			using Entry::Entry;
 
-			Glib::RefPtr<Gtk::RecentInfo> info;
+			//! The bookmarked URI
+			std::string uri;
+
+			//! The local path for file:// URIs, empty otherwise
+			std::filesystem::path path;
 		};
 
-		std::future<Entries> load_recent()
+		namespace xbel
+		{
+			/**
+			 * @brief A bookmark as read from recently-used.xbel
+			 * 
+			 */
+			struct Bookmark
+			{
+				std::string href;
+				std::string title;
+
+				//! ISO 8601 timestamp, sorts the same as the time it represents
+				std::string modified;
+			};
+
+			/**
+			 * @brief Gets the path to the recently used file
+			 * 
+			 * @return std::filesystem::path $XDG_DATA_HOME/recently-used.xbel
+			 */
+			std::filesystem::path file()
+			{
+				if (const char *dataHome{std::getenv("XDG_DATA_HOME")}; dataHome && *dataHome)
+				{
+					return std::filesystem::path{dataHome} / "recently-used.xbel";
+				}
+
+				const char *home{std::getenv("HOME")};
+				return std::filesystem::path{home ? home : ""} / ".local" / "share" / "recently-used.xbel";
+			}
+
+			/**
+			 * @brief Stream parses the bookmarks out of the file
+			 * 
+			 * @param path The xbel file
+			 * @return std::vector<Bookmark> The bookmarks in file order
+			 */
+			std::vector<Bookmark> read(const std::filesystem::path &path)
+			{
+				std::ifstream input{path};
+				std::vector<Bookmark> bookmarks;
+				std::optional<Bookmark> current;
+				bool inTitle{};
+
+				xml::Handler handler;
+				handler.on_start = [&current, &inTitle](std::string_view name, const xml::Attributes &attributes) {
+					if (name == "bookmark")
+					{
+						current.emplace();
+						current->href = xml::attribute(attributes, "href").value_or("");
+						current->modified = xml::attribute(attributes, "modified").value_or(xml::attribute(attributes, "added").value_or(""));
+					}
+					else if (name == "title" && current.has_value())
+					{
+						inTitle = true;
+					}
+				};
+
+				handler.on_end = [&bookmarks, &current, &inTitle](std::string_view name) {
+					if (name == "bookmark" && current.has_value())
+					{
+						if (!current->href.empty())
+						{
+							bookmarks.push_back(std::move(current.value()));
+						}
+
+						current.reset();
+					}
+					else if (name == "title")
+					{
+						inTitle = false;
+					}
+				};
+
+				handler.on_text = [&current, &inTitle](std::string_view text) {
+					if (inTitle && current.has_value())
+					{
+						current->title += text;
+					}
+				};
+
+				xml::parse(input, handler);
+
+				return bookmarks;
+			}
+		} // namespace xbel
+
+		namespace uri
+		{
+			/**
+			 * @brief Decodes %XX escapes
+			 * 
+			 * @param uri The escaped uri or part of it
+			 * @return std::string The decoded string
+			 */
+			std::string unescape(std::string_view uri)
+			{
+				std::string result;
+				result.reserve(uri.size());
+				for (size_t x{}; x < uri.size(); ++x)
+				{
+					if (uri[x] == '%' && x + 2 < uri.size() && std::isxdigit(static_cast<unsigned char>(uri[x + 1])) && std::isxdigit(static_cast<unsigned char>(uri[x + 2])))
+					{
+						result += static_cast<char>(std::stoi(std::string{uri.substr(x + 1, 2)}, nullptr, 16));
+						x += 2;
+					}
+					else
+					{
+						result += uri[x];
+					}
+				}
+
+				return result;
+			}
+
+			/**
+			 * @brief Gets the local path of a file:// uri
+			 * 
+			 * @param uri The uri
+			 * @return std::filesystem::path The path, empty if the uri is not a local file
+			 */
+			std::filesystem::path to_path(std::string_view uri)
+			{
+				constexpr std::string_view FILE_SCHEME{"file://"};
+				if (!uri.starts_with(FILE_SCHEME))
+				{
+					return {};
+				}
+
+				// Skip the host, if any
+				uri.remove_prefix(FILE_SCHEME.size());
+				const size_t slash{uri.find('/')};
+
+				return slash == std::string_view::npos ? std::filesystem::path{} : std::filesystem::path{unescape(uri.substr(slash))};
+			}
+		} // namespace uri
+
+		namespace mounts
 		{
-			static std::once_flag GTK_INIT_FLAG;
-			std::call_once(GTK_INIT_FLAG, Gtk::Main::init_gtkmm_internals);
-
-			return std::async(std::launch::async, []() {
-				Glib::RefPtr<Gtk::RecentManager> manager{Gtk::RecentManager::get_default()};
-				std::vector<Glib::RefPtr<Gtk::RecentInfo>> items{manager->get_items()};
-				items.erase(std::remove_if(std::begin(items), std::end(items), [](Glib::RefPtr<Gtk::RecentInfo> &info) {
-								return !info->exists();
-							}),
-							std::end(items));
-
-				Entries entries;
-				entries.reserve(items.size());
-				std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-				std::transform(std::begin(items), std::end(items), std::back_inserter(entries), [&converter](Glib::RefPtr<Gtk::RecentInfo> &info) {
-					auto entry{std::make_shared<RecentEntry>(converter.from_bytes(info->get_display_name() + ": " + info->get_uri_display()))};
-					entry->info = info;
-
-					return entry;
+			/**
+			 * @brief Gets the mount points from /proc/self/mounts
+			 * 
+			 * @return std::vector<std::string> The mount points, longest first
+			 */
+			std::vector<std::string> points()
+			{
+				std::vector<std::string> points;
+				std::ifstream mounts{"/proc/self/mounts"};
+				for (std::string device, point, rest; mounts >> device >> point && std::getline(mounts, rest);)
+				{
+					// Spaces and such are octal escaped, i.e: \040
+					std::string decoded;
+					for (size_t x{}; x < point.size(); ++x)
+					{
+						if (point[x] == '\\' && x + 3 < point.size())
+						{
+							decoded += static_cast<char>(std::stoi(point.substr(x + 1, 3), nullptr, 8));
+							x += 3;
+						}
+						else
+						{
+							decoded += point[x];
+						}
+					}
+
+					points.push_back(std::move(decoded));
+				}
+
+				std::sort(std::begin(points), std::end(points), [](const std::string &lhs, const std::string &rhs) {
+					return lhs.size() > rhs.size();
 				});
 
-				return entries;
+				return points;
+			}
+
+			/**
+			 * @brief Finds the mount point a path lives on
+			 * 
+			 * @param path The path to look up
+			 * @param points The mount points, longest first
+			 * @return std::string_view The mount point, or / if it wasn't found
+			 */
+			std::string_view find(const std::filesystem::path &path, const std::vector<std::string> &points)
+			{
+				const std::string &str{path.native()};
+				auto itr{std::find_if(std::begin(points), std::end(points), [&str](const std::string &point) {
+					return str.starts_with(point) && (point.ends_with('/') || str.size() == point.size() || str[point.size()] == '/');
+				})};
+
+				return itr == std::end(points) ? "/" : std::string_view{*itr};
+			}
+		} // namespace mounts
+
+		/**
+		 * @brief Finds entries whose files no longer exist.
+		 * 
+		 * Each mount gets its own thread so a slow network mount only holds up its own entries,
+		 * if a mount doesn't answer within EXISTS_TIMEOUT its entries are kept.
+		 * 
+		 * @param entries The entries to check
+		 * @return Entries The entries whose files are gone
+		 */
+		Entries find_missing(const Entries &entries)
+		{
+			trace::Span span{"recent::find_missing"};
+			struct Check
+			{
+				std::mutex lock;
+				std::condition_variable finished;
+				bool done{};
+				std::vector<std::filesystem::path> paths;
+				std::vector<bool> missing;
+			};
+
+			const std::vector<std::string> points{mounts::points()};
+			std::unordered_map<std::string_view, std::pair<std::shared_ptr<Check>, Entries>> groups;
+			for (const std::shared_ptr<Entry> &entry : entries)
+			{
+				const RecentEntry *recent{reinterpret_cast<const RecentEntry *>(entry.get())};
+				if (recent->path.empty())
+				{
+					continue;
+				}
+
+				auto &[check, grouped]{groups[mounts::find(recent->path, points)]};
+				if (!check)
+				{
+					check = std::make_shared<Check>();
+				}
+
+				check->paths.push_back(recent->path);
+				grouped.push_back(entry);
+			}
+
+			// The threads are detached, a hung mount must not keep us from exiting
+			for (auto &[mount, group] : groups)
+			{
+				std::thread([check{group.first}] {
+					std::vector<bool> missing;
+					missing.reserve(check->paths.size());
+					for (const std::filesystem::path &path : check->paths)
+					{
+						struct stat info{};
+						missing.push_back(0 != stat(path.c_str(), &info) && (errno == ENOENT || errno == ENOTDIR));
+					}
+
+					std::scoped_lock lock{check->lock};
+					check->missing = std::move(missing);
+					check->done = true;
+					check->finished.notify_all();
+				}).detach();
+			}
+
+			const auto deadline{std::chrono::steady_clock::now() + EXISTS_TIMEOUT};
+			Entries stale;
+			for (auto &[mount, group] : groups)
+			{
+				auto &[check, grouped]{group};
+				std::unique_lock lock{check->lock};
+				if (!check->finished.wait_until(lock, deadline, [&check] { return check->done; }))
+				{
+					continue;
+				}
+
+				for (size_t x{}; x < grouped.size(); ++x)
+				{
+					if (check->missing[x])
+					{
+						stale.push_back(grouped[x]);
+					}
+				}
+			}
+
+			return stale;
+		}
+
+		namespace preview
+		{
+			/**
+			 * @brief Runs work on a detached thread, giving up on it after PREVIEW_TIMEOUT.
+			 * 
+			 * A hung mount only costs a thread, it never holds up the preview thread.
+			 * 
+			 * @tparam Result What the work produces
+			 * @param work The work to do, must not reference anything that may go away
+			 * @param result [Out] The result if the work finished in time
+			 * @param stop Gives up early when the preview is no longer wanted
+			 * @return true - The work finished in time
+			 */
+			template <typename Result>
+			bool with_timeout(std::function<Result()> work, Result &result, std::stop_token stop)
+			{
+				struct State
+				{
+					std::mutex lock;
+					std::condition_variable_any finished;
+					std::optional<Result> result;
+				};
+
+				auto state{std::make_shared<State>()};
+				std::thread([state, work{std::move(work)}] {
+					Result result{work()};
+
+					std::scoped_lock lock{state->lock};
+					state->result = std::move(result);
+					state->finished.notify_all();
+				}).detach();
+
+				std::unique_lock lock{state->lock};
+				if (!state->finished.wait_until(lock, stop, std::chrono::steady_clock::now() + PREVIEW_TIMEOUT, [&state] { return state->result.has_value(); }))
+				{
+					return false;
+				}
+
+				result = std::move(state->result.value());
+				return true;
+			}
+
+			/**
+			 * @brief Reads up to PREVIEW_BYTES from the start of a file
+			 * 
+			 * @param path The file to read
+			 * @return std::optional<std::string> The bytes read, nullopt if the file can't be read
+			 */
+			std::optional<std::string> read_head(const std::filesystem::path &path)
+			{
+				const int fd{open(path.c_str(), O_RDONLY | O_CLOEXEC | O_NOCTTY)};
+				if (fd < 0)
+				{
+					return std::nullopt;
+				}
+
+				std::string head(PREVIEW_BYTES, '\0');
+				size_t length{};
+				while (length < head.size())
+				{
+					const ssize_t count{pread(fd, head.data() + length, head.size() - length, static_cast<off_t>(length))};
+					if (count < 0 && errno == EINTR)
+					{
+						continue;
+					}
+
+					if (count <= 0)
+					{
+						break;
+					}
+
+					length += static_cast<size_t>(count);
+				}
+
+				close(fd);
+				head.resize(length);
+
+				return head;
+			}
+
+			/**
+			 * @brief Checks how much of the text is UTF-8, a sequence cut off by the end is not an error
+			 * 
+			 * @param text The text to check
+			 * @return size_t Length of the whole sequences at the start, npos if the text is not UTF-8
+			 */
+			size_t valid_utf8(std::string_view text)
+			{
+				size_t x{};
+				while (x < text.size())
+				{
+					const unsigned char lead{static_cast<unsigned char>(text[x])};
+					const size_t length{lead < 0x80 ? 1u : (lead >> 5) == 0x6 ? 2u : (lead >> 4) == 0xE ? 3u : (lead >> 3) == 0x1E ? 4u : 0u};
+					if (length == 0)
+					{
+						return std::string_view::npos;
+					}
+
+					for (size_t y{1}; y < length; ++y)
+					{
+						if (x + y >= text.size())
+						{
+							return x;
+						}
+
+						if ((static_cast<unsigned char>(text[x + y]) >> 6) != 0x2)
+						{
+							return std::string_view::npos;
+						}
+					}
+
+					x += length;
+				}
+
+				return x;
+			}
+
+			/**
+			 * @brief Renders the head of a file as text, or a note if it isn't text
+			 * 
+			 * @param path The file the head is from
+			 * @param info The file's stat
+			 * @param head The start of the file
+			 * @return ftxui::Element The preview
+			 */
+			ftxui::Element render(const std::filesystem::path &path, const struct stat &info, std::string_view head)
+			{
+				// Sequences the validation lets through but codecvt rejects, i.e: surrogates, don't throw
+				std::wstring_convert<std::codecvt_utf8<wchar_t>> converter{std::string{}, std::wstring{L"?"}};
+				ftxui::Elements lines{ftxui::text(converter.from_bytes(path.filename().string())) | ftxui::bold,
+									  ftxui::text(std::to_wstring(info.st_size) + L" bytes") | ftxui::dim,
+									  ftxui::separator()};
+
+				const size_t valid{valid_utf8(head)};
+				if (valid == std::string_view::npos || head.find('\0') != std::string_view::npos)
+				{
+					lines.push_back(ftxui::text(L"Binary file") | ftxui::dim);
+					return ftxui::vbox(std::move(lines));
+				}
+
+				const std::wstring text{converter.from_bytes(head.data(), head.data() + valid)};
+				if (converter.converted() != valid)
+				{
+					lines.push_back(ftxui::text(L"Binary file") | ftxui::dim);
+					return ftxui::vbox(std::move(lines));
+				}
+
+				for (size_t start{}; start < text.size() && lines.size() < PREVIEW_LINES + 3;)
+				{
+					const size_t end{std::min(text.find(L'\n', start), text.size())};
+					std::wstring line;
+					line.reserve(end - start);
+					for (wchar_t c : std::wstring_view{text}.substr(start, end - start))
+					{
+						if (c == L'\t')
+						{
+							line.append(4, L' ');
+						}
+						else if (c >= L' ' && c != 0x7F)
+						{
+							line += c;
+						}
+					}
+
+					lines.push_back(ftxui::text(std::move(line)));
+					start = end + 1;
+				}
+
+				return ftxui::vbox(std::move(lines));
+			}
+		} // namespace preview
+
+		/**
+		 * @brief Loads the recently used files, showing them right away and dropping missing ones once checked
+		 * 
+		 * @param batches Where to put the entries
+		 * @param notify Called when entries were added or removed
+		 */
+		void load_recent(Batches &batches, const std::function<void()> &notify)
+		{
+			trace::Span span{"recent::load_recent"};
+			std::vector<xbel::Bookmark> bookmarks{xbel::read(xbel::file())};
+			std::stable_sort(std::begin(bookmarks), std::end(bookmarks), [](const xbel::Bookmark &lhs, const xbel::Bookmark &rhs) {
+				return lhs.modified > rhs.modified;
+			});
+
+			Entries entries;
+			entries.reserve(bookmarks.size());
+			std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+			std::transform(std::begin(bookmarks), std::end(bookmarks), std::back_inserter(entries), [&converter](xbel::Bookmark &bookmark) {
+				std::filesystem::path path{uri::to_path(bookmark.href)};
+				std::string name{bookmark.title};
+				if (name.empty())
+				{
+					name = path.empty() ? uri::unescape(std::string_view{bookmark.href}.substr(bookmark.href.find_last_of('/') + 1)) : path.filename().string();
+				}
+
+				auto entry{std::make_shared<RecentEntry>(converter.from_bytes(name + ": " + (path.empty() ? bookmark.href : path.string())))};
+				entry->uri = std::move(bookmark.href);
+				entry->path = std::move(path);
+
+				return entry;
 			});
+
+			batches.Append(Entries{entries});
+			notify();
+
+			if (Entries stale{find_missing(entries)}; !stale.empty())
+			{
+				batches.Remove(stale);
+			}
+
+			batches.Finish();
+			notify();
 		}
 
-		recent::recent() : m_loading{load_recent()}
+		recent::recent() : m_previews{PREVIEW_CACHE_SIZE}, m_loading{executor::submit(executor::Lane::Background, [this](std::stop_token) { load_recent(m_batches, [this] { Notify(); }); })}
 		{
 		}
 
 		const Entries &recent::Results()
 		{
-			if (m_entries.empty() && m_loading.valid())
+			m_batches.Drain(m_entries);
+
+			return m_entries;
+		}
+
+		ftxui::Element recent::Preview(const Entry &selected, std::stop_token stop)
+		{
+			const RecentEntry *entry{reinterpret_cast<const RecentEntry *>(&selected)};
+			if (entry->path.empty())
 			{
-				m_entries = m_loading.get();
+				std::wstring_convert<std::codecvt_utf8<wchar_t>> converter{std::string{}, std::wstring{L"?"}};
+				return ftxui::text(converter.from_bytes(uri::unescape(entry->uri))) | ftxui::dim;
 			}
 
-			return m_entries;
+			// Even stat can hang on a network mount
+			std::optional<struct stat> info;
+			if (!preview::with_timeout<std::optional<struct stat>>([path{entry->path}]() -> std::optional<struct stat> {
+					struct stat info{};
+					return 0 == stat(path.c_str(), &info) ? std::optional<struct stat>{info} : std::nullopt;
+				}, info, stop))
+			{
+				// Not cached, so a mount that comes back gets previewed the next time the file is selected
+				return nullptr;
+			}
+
+			if (!info.has_value())
+			{
+				return ftxui::text(L"Missing") | ftxui::dim;
+			}
+
+			if (!S_ISREG(info->st_mode))
+			{
+				return ftxui::text(S_ISDIR(info->st_mode) ? L"Directory" : L"Not a regular file") | ftxui::dim;
+			}
+
+			const std::string key{entry->path.native() + '\0' + std::to_string(info->st_mtim.tv_sec) + '.' + std::to_string(info->st_mtim.tv_nsec)};
+			{
+				std::scoped_lock lock{m_previewsLock};
+				if (const ftxui::Element *cached{m_previews.Find(key)})
+				{
+					return *cached;
+				}
+			}
+
+			std::optional<std::string> head;
+			if (!preview::with_timeout<std::optional<std::string>>([path{entry->path}] { return preview::read_head(path); }, head, stop))
+			{
+				return nullptr;
+			}
+
+			if (!head.has_value())
+			{
+				return ftxui::text(L"Can't read file") | ftxui::dim;
+			}
+
+			ftxui::Element rendered{preview::render(entry->path, info.value(), head.value())};
+			std::scoped_lock lock{m_previewsLock};
+			m_previews.Put(key, rendered);
+
+			return rendered;
 		}
 
 		PostExec recent::Execute(const Entry &result, const std::wstring &)
 		{
 			const RecentEntry *entry{reinterpret_cast<const RecentEntry *>(&result)};
-			std::ostringstream cmd;
-			cmd << "xdg-open " << entry->info->get_uri();
+			Command command;
+			command.path = "xdg-open";
+			command.argv = {"xdg-open", entry->uri};
 
-			return spawn(commands::parse(cmd.str())) ? PostExec::CloseSuccess : PostExec::CloseFailure;
+			return spawn(std::move(command)) ? PostExec::CloseSuccess : PostExec::CloseFailure;
 		}
 	} // namespace modes
 } // namespace yaltl
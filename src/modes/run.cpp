@@ -1,6 +1,7 @@
 #include "modes/run.h"
 
 #include "utils/spawn.h"
+#include "utils/trace.h"
 
 #include <mtl/string.hpp>
 
@@ -11,6 +12,7 @@
 #include <locale>
 #include <numeric>
 #include <sstream>
+#include <unordered_set>
 
 #ifdef WIN32
 #define PATH_DELIM ";"
@@ -32,39 +34,43 @@ namespace yaltl
             std::filesystem::path path;
         };
 
-        /**
-         * @brief Gets all the binaries from $PATH
-         * 
-         * @return std::future<std::vector<std::wstring>> 
-         */
-        std::future<Entries> load()
+        void load(Batches &batches, const std::function<void()> &notify, std::stop_token stop)
         {
-            return std::async(std::launch::async, []() -> Entries {
-                const char *environmentPath{std::getenv("PATH")};
+            trace::Span span{"run::load"};
+            const char *environmentPath{std::getenv("PATH")};
 
-                // There is no path environment
-                if (!environmentPath)
+            // There is no path environment
+            if (!environmentPath)
+            {
+                batches.Finish();
+                notify();
+                return;
+            }
+
+            std::vector<std::string_view> paths;
+            mtl::string::split(environmentPath, PATH_DELIM, std::back_inserter(paths));
+
+            // Earlier directories in $PATH win, same as a shell lookup
+            std::unordered_set<std::wstring> seen;
+            std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+            for (auto &path : paths)
+            {
+                if (stop.stop_requested())
                 {
-                    return {};
+                    break;
                 }
 
-                std::vector<std::string_view> paths;
-                mtl::string::split(environmentPath, PATH_DELIM, std::back_inserter(paths));
-
-                std::vector<std::filesystem::path> binpaths;
-                for (auto &path : paths)
+                if (!std::filesystem::exists(path))
                 {
-                    if (!std::filesystem::exists(path))
-                    {
-                        continue;
-                    }
+                    continue;
+                }
 
-                    std::filesystem::directory_iterator dir{path};
+                std::filesystem::directory_iterator dir{path};
 
-                    std::transform(std::filesystem::begin(dir), std::filesystem::end(dir), std::back_inserter(binpaths), [](const std::filesystem::directory_entry &entry) {
-                        return entry.path();
-                    });
-                }
+                std::vector<std::filesystem::path> binpaths;
+                std::transform(std::filesystem::begin(dir), std::filesystem::end(dir), std::back_inserter(binpaths), [](const std::filesystem::directory_entry &entry) {
+                    return entry.path();
+                });
 
                 binpaths.erase(std::remove_if(std::begin(binpaths), std::end(binpaths), [](const std::filesystem::path &path) {
 #ifdef WIN32
@@ -81,7 +87,6 @@ namespace yaltl
 
                 Entries entries;
                 entries.reserve(binpaths.size());
-                std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
                 std::transform(std::begin(binpaths), std::end(binpaths), std::back_inserter(entries), [&converter](std::filesystem::path path) {
                     auto entry{std::make_shared<RunEntry>(converter.from_bytes(path.filename().string()))};
                     entry->path = std::move(path);
@@ -93,26 +98,29 @@ namespace yaltl
                     return lhs->display < rhs->display;
                 });
 
-                entries.erase(std::unique(std::begin(entries), std::end(entries), [](const std::shared_ptr<Entry> &lhs, const std::shared_ptr<Entry> &rhs) {
-                                  return lhs->display == rhs->display;
+                entries.erase(std::remove_if(std::begin(entries), std::end(entries), [&seen](const std::shared_ptr<Entry> &entry) {
+                                  return !seen.insert(entry->display).second;
                               }),
                               std::end(entries));
 
-                return entries;
-            });
+                if (!entries.empty())
+                {
+                    batches.Append(std::move(entries));
+                    notify();
+                }
+            }
+
+            batches.Finish();
+            notify();
         }
 
-        run::run() : m_loader{load()}
+        run::run() : m_loader{executor::submit(executor::Lane::Background, [this](std::stop_token stop) { load(m_batches, [this] { Notify(); }, stop); })}
         {
         }
 
         const Entries &run::Results()
         {
-            // Wait to finish loaded if needed
-            if (m_binaries.empty() && m_loader.valid())
-            {
-                m_binaries = m_loader.get();
-            }
+            m_batches.Drain(m_binaries);
 
             return m_binaries;
         }
@@ -1,44 +1,258 @@
 #include "modes/script.h"
 
-#include "utils/popen.h"
+#include "utils/subprocess.h"
+#include "utils/trace.h"
+#include "utils/utf8.h"
 
-#include <cstdio>
+#include <codecvt>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <locale>
 #include <memory>
+#include <random>
 #include <sstream>
 #include <vector>
 
+constexpr std::string_view CACHE_MAGIC{"YALTLSCR 1\n"};
+
 namespace yaltl
 {
     namespace modes
     {
-        std::future<Entries> async_popen(const std::string &command)
+        /**
+         * @brief Turns lines of output into entries
+         * 
+         * @param lines The lines the script printed
+         * @return Entries One entry per line
+         */
+        Entries make_entries(const std::vector<std::string_view> &lines)
         {
-            return std::async(std::launch::async, [command] {
-                std::vector<std::wstring> contents{popen(command)};
-                Entries res(contents.size());
-                std::transform(std::begin(contents), std::end(contents), std::begin(res), [](std::wstring &line) {
-                    return std::make_shared<Entry>(std::move(line));
-                });
-
-                return res;
+            // Bad output shouldn't take the worker down with it, bytes that aren't UTF-8 are replaced on their own
+            Entries entries(lines.size());
+            std::transform(std::begin(lines), std::end(lines), std::begin(entries), [](std::string_view line) {
+                return std::make_shared<Entry>(utf8::widen(line));
             });
+
+            return entries;
+        }
+
+        namespace cache
+        {
+            /**
+             * @brief Gets where a command's output is cached
+             * 
+             * @param command The command line
+             * @return std::filesystem::path $XDG_CACHE_HOME/yaltl/scripts/<hash of command>, empty if there's no cache directory
+             */
+            std::filesystem::path path(const std::string &command)
+            {
+                std::filesystem::path base;
+                if (const char *cache{std::getenv("XDG_CACHE_HOME")}; cache && *cache)
+                {
+                    base = std::filesystem::path{cache};
+                }
+                else if (const char *home{std::getenv("HOME")}; home && *home)
+                {
+                    base = std::filesystem::path{home} / ".cache";
+                }
+                else
+                {
+                    return {};
+                }
+
+                // FNV-1a, stable between runs unlike std::hash
+                uint64_t hash{14695981039346656037ull};
+                for (unsigned char ch : command)
+                {
+                    hash = (hash ^ ch) * 1099511628211ull;
+                }
+
+                std::ostringstream name;
+                name << std::hex << std::setw(16) << std::setfill('0') << hash;
+
+                return base / "yaltl" / "scripts" / name.str();
+            }
+
+            /**
+             * @brief Reads the output the command printed last time
+             * 
+             * @param command The command line
+             * @param entries [Out] The cached output
+             * @param age [Out] How long ago the output was cached
+             * @return true - The command's output was cached
+             */
+            bool read(const std::string &command, Entries &entries, std::filesystem::file_time_type::duration &age)
+            {
+                const std::filesystem::path file{path(command)};
+                std::error_code error;
+                const std::filesystem::file_time_type written{std::filesystem::last_write_time(file, error)};
+                if (file.empty() || error)
+                {
+                    return false;
+                }
+
+                std::ifstream in{file, std::ios::binary};
+                const std::string contents{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+
+                // The command is stored as well, in case another one hashes the same
+                std::string_view view{contents};
+                if (!view.starts_with(CACHE_MAGIC))
+                {
+                    return false;
+                }
+
+                view.remove_prefix(CACHE_MAGIC.size());
+                const size_t sizeEnd{view.find('\n')};
+                if (sizeEnd == std::string_view::npos || view.substr(0, sizeEnd) != std::to_string(command.size()) ||
+                    view.substr(sizeEnd + 1, command.size()) != command)
+                {
+                    return false;
+                }
+
+                view.remove_prefix(std::min(view.size(), sizeEnd + 1 + command.size() + 1));
+
+                std::vector<std::string_view> lines;
+                for (size_t start{}, end{view.find('\n')}; start < view.size(); start = end + 1, end = view.find('\n', start))
+                {
+                    end = std::min(end, view.size());
+                    if (end > start)
+                    {
+                        lines.push_back(view.substr(start, end - start));
+                    }
+                }
+
+                entries = make_entries(lines);
+                age = std::filesystem::file_time_type::clock::now() - written;
+
+                return true;
+            }
+
+            /**
+             * @brief Caches the output of a command
+             * 
+             * @param command The command line
+             * @param lines The lines it printed
+             */
+            void write(const std::string &command, const std::vector<std::string_view> &lines)
+            {
+                const std::filesystem::path file{path(command)};
+                if (file.empty())
+                {
+                    return;
+                }
+
+                std::error_code error;
+                std::filesystem::create_directories(file.parent_path(), error);
+
+                // Write to the side and swap in so a concurrent yaltl never reads a partial cache
+                std::filesystem::path temp{file};
+                temp += "." + std::to_string(std::random_device{}());
+                {
+                    std::ofstream out{temp, std::ios::binary | std::ios::trunc};
+                    out << CACHE_MAGIC << command.size() << '\n'
+                        << command << '\n';
+                    for (std::string_view line : lines)
+                    {
+                        out << line << '\n';
+                    }
+
+                    if (!out)
+                    {
+                        out.close();
+                        std::filesystem::remove(temp, error);
+                        return;
+                    }
+                }
+
+                std::filesystem::rename(temp, file, error);
+                if (error)
+                {
+                    std::filesystem::remove(temp, error);
+                }
+            }
+        } // namespace cache
+
+        script::script(std::string_view name, std::string_view script, std::optional<std::chrono::seconds> ttl) : m_name(utf8::widen(name)),
+                                                                                                                  m_script(std::string(script))
+        {
+            // We run the script before the user may even come to script mode
+            Start(m_script, ttl);
         }
 
-        script::script(std::string_view name, std::string_view script) : m_name(std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>>().from_bytes(std::string(name))),
-                                                                         m_script(std::string(script)),
-                                                                         m_loader(async_popen(m_script))
+        void script::Start(std::string command, std::optional<std::chrono::seconds> ttl)
         {
+            m_worker = std::jthread{[this, command{std::move(command)}, ttl](std::stop_token stop) {
+                trace::Span span{"script::Start"};
+                // Show what the script printed last time right away, and only run it again once that's older than the ttl
+                bool showingCache{};
+                if (ttl.has_value())
+                {
+                    Entries cached;
+                    std::filesystem::file_time_type::duration age{};
+                    if (cache::read(command, cached, age))
+                    {
+                        showingCache = true;
+                        m_batches.Append(std::move(cached));
+                        Notify();
+
+                        if (age < ttl.value())
+                        {
+                            m_batches.Finish();
+                            Notify();
+                            return;
+                        }
+                    }
+                }
+
+                subprocess::Options options;
+                options.argv = {command};
+                options.shell = true;
+                options.stop = stop;
+
+                // Over cached results, the new ones are swapped in all at once when the script is done
+                if (!showingCache)
+                {
+                    options.on_lines = [this](const std::vector<std::string_view> &lines) {
+                        m_batches.Append(make_entries(lines));
+                        Notify();
+                    };
+                }
+
+                const subprocess::Output output{subprocess::run(std::move(options))};
+                if (ttl.has_value() && output.status == 0 && !output.killed)
+                {
+                    cache::write(command, output.lines);
+                    if (showingCache)
+                    {
+                        m_batches.Replace(make_entries(output.lines));
+                    }
+                }
+
+                m_batches.Finish();
+                Notify();
+            }};
         }
 
         const Entries &script::Results()
         {
-            // We run the script before the user may even come to script mode
-            if (m_results.empty() && m_loader.valid())
+            m_batches.Drain(m_results);
+
+            return m_results;
+        }
+
+        std::optional<PostExec> script::Finished()
+        {
+            // The script has exited nicely once it printed nothing for the selected result
+            if (!m_executed || !m_batches.Done())
             {
-                m_results = m_loader.get();
+                return std::nullopt;
             }
 
-            return m_results;
+            m_batches.Drain(m_results);
+
+            return m_results.empty() ? std::optional<PostExec>{PostExec::CloseSuccess} : std::nullopt;
         }
 
         PostExec script::Execute(const Entry &result, const std::wstring &)
@@ -49,14 +263,14 @@ namespace yaltl
             std::ostringstream cmd;
             cmd << m_script << " " << converter.to_bytes(result.display);
 
-            // Don't load async since user since user is interacting with us anyways
-            std::vector<std::wstring> output{popen(cmd.str())};
-            m_results.resize(output.size());
-            std::transform(std::begin(output), std::end(output), std::begin(m_results), [](std::wstring &line) {
-                return std::make_shared<Entry>(std::move(line));
-            });
+            // Kill the last run if it's still going so its output can't mix with the new results
+            m_worker = std::jthread{};
+            m_batches.Restart();
+            m_executed = true;
+            Start(cmd.str(), std::nullopt);
 
-            return m_results.empty() ? PostExec::CloseSuccess : PostExec::StayOpen;
+            // Finished closes yaltl if the script prints nothing
+            return PostExec::StayOpen;
         }
     } // namespace modes
 
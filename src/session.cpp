@@ -0,0 +1,255 @@
+#include "session.h"
+#include "utils/histogram.h"
+#include "utils/json.h"
+#include "utils/terminal.h"
+#include "utils/utf8.h"
+
+#include <codecvt>
+#include <fstream>
+#include <iostream>
+#include <locale>
+#include <thread>
+
+#include <ftxui/screen/screen.hpp>
+
+//! How long a mode gets to finish loading before keys are replayed anyway
+constexpr std::chrono::seconds LOAD_TIMEOUT{10};
+
+namespace yaltl
+{
+    namespace session
+    {
+        Recorder::Recorder(Yaltl &yaltl, const std::string &file) : m_yaltl(yaltl), m_out(fopen(file.c_str(), "w")), m_start(std::chrono::steady_clock::now()), m_mode(yaltl.ActiveMode().Name())
+        {
+            Add(&m_yaltl);
+            if (!m_out)
+            {
+                return;
+            }
+
+            const ftxui::Terminal::Dimensions size{terminal::size()};
+            fprintf(m_out.get(), "{\"session\":1,\"width\":%d,\"height\":%d}\n", size.dimx, size.dimy);
+
+            m_yaltl.on_execute = [this](const Entry &result, const std::wstring &query) {
+                std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+                fprintf(m_out.get(), "{\"t\":%llu,\"execute\":%s,\"query\":%s}\n",
+                        static_cast<unsigned long long>(Now()),
+                        json::quote(converter.to_bytes(result.display)).c_str(),
+                        json::quote(converter.to_bytes(query)).c_str());
+            };
+        }
+
+        uint64_t Recorder::Now() const
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_start).count();
+        }
+
+        bool Recorder::OnEvent(ftxui::Event event)
+        {
+            if (!m_out)
+            {
+                return m_yaltl.OnEvent(event);
+            }
+
+            // Background wake ups aren't keys, replaying lets loading finish instead
+            if (ftxui::Event::Custom != event)
+            {
+                std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+                const std::string key{event.is_character() ? "\"char\":" + json::quote(converter.to_bytes(event.character()))
+                                                           : "\"special\":" + json::quote(event.input())};
+                fprintf(m_out.get(), "{\"t\":%llu,%s}\n", static_cast<unsigned long long>(Now()), key.c_str());
+            }
+
+            const bool handled{m_yaltl.OnEvent(event)};
+            if (std::wstring mode{m_yaltl.ActiveMode().Name()}; mode != m_mode)
+            {
+                std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+                fprintf(m_out.get(), "{\"t\":%llu,\"mode\":%s}\n", static_cast<unsigned long long>(Now()), json::quote(converter.to_bytes(mode)).c_str());
+                m_mode = std::move(mode);
+            }
+
+            return handled;
+        }
+
+        ftxui::Element Recorder::Render()
+        {
+            return m_yaltl.Render();
+        }
+
+        namespace
+        {
+            //! One line of a recorded session
+            struct Record
+            {
+                uint64_t t{};
+                std::optional<std::string> character;
+                std::optional<std::string> special;
+                std::optional<std::string> mode;
+                std::optional<std::string> execute;
+                uint64_t width{};
+                uint64_t height{};
+            };
+
+            bool parse(std::string_view line, Record &record)
+            {
+                json::Scanner scanner{line};
+                return scanner.Object([&scanner, &record](std::string_view key) {
+                    if (key == "t")
+                    {
+                        return scanner.Number(record.t);
+                    }
+
+                    if (key == "width")
+                    {
+                        return scanner.Number(record.width);
+                    }
+
+                    if (key == "height")
+                    {
+                        return scanner.Number(record.height);
+                    }
+
+                    auto string{[&scanner](std::optional<std::string> &out) { return scanner.String(out.emplace()); }};
+                    if (key == "char")
+                    {
+                        return string(record.character);
+                    }
+
+                    if (key == "special")
+                    {
+                        return string(record.special);
+                    }
+
+                    if (key == "mode")
+                    {
+                        return string(record.mode);
+                    }
+
+                    if (key == "execute")
+                    {
+                        return string(record.execute);
+                    }
+
+                    return scanner.Skip();
+                });
+            }
+
+            //! Lets the mode finish loading and picks up everything it loaded, ranked
+            void settle(Yaltl &yaltl)
+            {
+                const std::chrono::steady_clock::time_point deadline{std::chrono::steady_clock::now() + LOAD_TIMEOUT};
+                while (yaltl.ActiveMode().Loading() && std::chrono::steady_clock::now() < deadline)
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds{1});
+                }
+
+                yaltl.OnEvent(ftxui::Event::Custom);
+                yaltl.FinishSearch();
+            }
+        } // namespace
+
+        int replay(Yaltl &yaltl, const std::string &file, std::ostream &report)
+        {
+            std::ifstream in{file};
+            std::string line;
+            Record header;
+            if (!std::getline(in, line) || !parse(line, header) || header.width == 0 || header.height == 0)
+            {
+                std::cerr << "yaltl: " << file << " isn't a recorded session" << std::endl;
+                return -1;
+            }
+
+            const int width{static_cast<int>(header.width)};
+            const int height{static_cast<int>(header.height)};
+            terminal::pin(ftxui::Terminal::Dimensions{width, height});
+
+            std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+            Histogram latency;
+            std::string keys;
+            size_t mismatches{};
+            std::shared_ptr<Entry> selected;
+
+            settle(yaltl);
+            while (std::getline(in, line))
+            {
+                Record record;
+                if (!parse(line, record))
+                {
+                    continue;
+                }
+
+                if (record.mode.has_value())
+                {
+                    if (const std::string mode{converter.to_bytes(yaltl.ActiveMode().Name())}; mode != record.mode.value())
+                    {
+                        std::cerr << "yaltl: at " << record.t << "us the mode was " << record.mode.value() << ", replayed " << mode << std::endl;
+                        ++mismatches;
+                    }
+
+                    continue;
+                }
+
+                if (record.execute.has_value())
+                {
+                    const std::string replayed{selected ? converter.to_bytes(selected->display) : std::string{}};
+                    if (replayed != record.execute.value())
+                    {
+                        std::cerr << "yaltl: at " << record.t << "us " << record.execute.value() << " was executed, replayed " << replayed << std::endl;
+                        ++mismatches;
+                    }
+
+                    continue;
+                }
+
+                const std::wstring character{utf8::widen(record.character.value_or(std::string{}))};
+                if (character.empty() && !record.special.has_value())
+                {
+                    continue;
+                }
+
+                ftxui::Event event{character.empty() ? ftxui::Event::Special(record.special.value()) : ftxui::Event::Character(character.front())};
+
+                // Nothing is launched or closed, only what would have been is kept
+                if (ftxui::Event::Return == event)
+                {
+                    selected = yaltl.Selected();
+                    continue;
+                }
+
+                if (ftxui::Event::Escape == event)
+                {
+                    break;
+                }
+
+                // The key, the update the UI would wake up for with every source ranked, and drawing the frame it causes
+                const std::chrono::steady_clock::time_point begin{std::chrono::steady_clock::now()};
+                yaltl.OnEvent(event);
+                yaltl.OnEvent(ftxui::Event::Custom);
+                yaltl.FinishSearch();
+                ftxui::Screen screen{width, height};
+                ftxui::Render(screen, yaltl.Render());
+                const size_t drawn{screen.ToString().size()};
+                const uint64_t spent{static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count())};
+
+                latency.Record(spent);
+                keys += (keys.empty() ? "\n" : ",\n");
+                keys += "{\"t\":" + std::to_string(record.t) +
+                        ",\"key\":" + json::quote(record.character.value_or(record.special.value_or(std::string{}))) +
+                        ",\"ns\":" + std::to_string(spent) +
+                        ",\"bytes\":" + std::to_string(drawn) + "}";
+
+                // Switching modes may need loading, which isn't the key's latency
+                settle(yaltl);
+            }
+
+            const std::shared_ptr<Entry> last{yaltl.Selected()};
+            report << "{\"mismatches\":" << mismatches
+                   << ",\"mode\":" << json::quote(converter.to_bytes(yaltl.ActiveMode().Name()))
+                   << ",\"selection\":" << (last ? json::quote(converter.to_bytes(last->display)) : "null")
+                   << ",\"latency\":" << latency.Json()
+                   << ",\"keys\":[" << keys << "\n]}" << std::endl;
+
+            return mismatches > 0 ? 1 : 0;
+        }
+    } // namespace session
+} // namespace yaltl
@@ -0,0 +1,261 @@
+#include "utils/charindex.h"
+
+#include <algorithm>
+#include <bit>
+#include <cwctype>
+#include <limits>
+
+//! Characters in more than this share of the entries aren't kept, the search has to scan most entries anyway
+constexpr size_t DENSE_PERCENT{80};
+
+//! Once this few candidates are left, scoring them costs less than intersecting any more characters
+constexpr size_t FEW_CANDIDATES{4096};
+
+//! How often building checks if it should stop
+constexpr size_t STOP_INTERVAL{4096};
+
+namespace yaltl
+{
+    namespace
+    {
+        /**
+         * @brief Gets where a character is indexed
+         *
+         * @param ch The character, already folded
+         * @return std::optional<size_t> The posting, nullopt if it isn't indexed
+         */
+        std::optional<size_t> slot(wchar_t ch)
+        {
+            if (ch >= L'a' && ch <= L'z')
+            {
+                return ch - L'a';
+            }
+
+            if (ch >= L'0' && ch <= L'9')
+            {
+                return 26 + (ch - L'0');
+            }
+
+            return std::nullopt;
+        }
+
+        //! Marks the characters of text in a set of postings
+        void mark(std::wstring_view text, uint64_t &seen)
+        {
+            // The regex backends fold with towlower too, i.e: the Kelvin sign is a k
+            for (wchar_t ch : text)
+            {
+                if (std::optional<size_t> posting{slot(static_cast<wchar_t>(std::towlower(ch)))}; posting.has_value())
+                {
+                    seen |= uint64_t{1} << posting.value();
+                }
+            }
+        }
+
+        //! Appends a gap, 7 bits at a time
+        void encode(std::vector<uint8_t> &out, uint32_t gap)
+        {
+            for (; gap >= 0x80; gap >>= 7)
+            {
+                out.push_back(static_cast<uint8_t>(gap | 0x80));
+            }
+
+            out.push_back(static_cast<uint8_t>(gap));
+        }
+
+        /**
+         * @brief Goes through the entries of a posting in order
+         *
+         * @param gaps The posting
+         * @param visit Called with each entry, returns false to stop
+         */
+        template <typename Visit>
+        void decode(const std::vector<uint8_t> &gaps, Visit visit)
+        {
+            uint32_t entry{};
+            uint32_t gap{};
+            uint32_t shift{};
+            for (uint8_t byte : gaps)
+            {
+                gap |= static_cast<uint32_t>(byte & 0x7f) << shift;
+                shift += 7;
+                if (byte & 0x80)
+                {
+                    continue;
+                }
+
+                entry += gap;
+                gap = 0;
+                shift = 0;
+                if (!visit(entry))
+                {
+                    return;
+                }
+            }
+        }
+    } // namespace
+
+    std::optional<CharIndex> CharIndex::build(const Entries &entries, size_t budget, std::stop_token stop)
+    {
+        if (entries.size() > std::numeric_limits<uint32_t>::max())
+        {
+            return std::nullopt;
+        }
+
+        CharIndex index;
+        index.m_entries = entries.size();
+        for (size_t x{}; x < entries.size(); ++x)
+        {
+            if (x % STOP_INTERVAL == 0 && stop.stop_requested())
+            {
+                return std::nullopt;
+            }
+
+            // Any criteria can match, so an entry is in every posting one of them is
+            uint64_t seen{};
+            const Entry &entry{*entries[x]};
+            if (entry.criteria.has_value())
+            {
+                for (const std::wstring &criteria : entry.criteria.value())
+                {
+                    mark(criteria, seen);
+                }
+            }
+            else
+            {
+                mark(entry.display, seen);
+            }
+
+            if (!index.Add(static_cast<uint32_t>(x), seen, budget))
+            {
+                return std::nullopt;
+            }
+        }
+
+        index.Finish();
+        return index;
+    }
+
+    std::optional<CharIndex> CharIndex::build(const FrontCoded &lines, size_t budget, std::stop_token stop)
+    {
+        if (lines.Size() > std::numeric_limits<uint32_t>::max())
+        {
+            return std::nullopt;
+        }
+
+        CharIndex index;
+        index.m_entries = lines.Size();
+        bool built{true};
+        lines.Scan(0, lines.Size(), [&index, &built, budget, &stop](size_t x, std::wstring_view line) {
+            uint64_t seen{};
+            mark(line, seen);
+            built = !(x % STOP_INTERVAL == 0 && stop.stop_requested()) && index.Add(static_cast<uint32_t>(x), seen, budget);
+            return built;
+        });
+
+        if (!built)
+        {
+            return std::nullopt;
+        }
+
+        index.Finish();
+        return index;
+    }
+
+    bool CharIndex::Add(uint32_t entry, uint64_t seen, size_t budget)
+    {
+        // Counting what the postings reserved rather than used keeps their growth within the budget too
+        for (; seen; seen &= seen - 1)
+        {
+            Posting &posting{m_postings[std::countr_zero(seen)]};
+            const size_t reserved{posting.gaps.capacity()};
+            encode(posting.gaps, entry - posting.last);
+            m_bytes += posting.gaps.capacity() - reserved;
+            posting.last = entry;
+            ++posting.count;
+        }
+
+        return m_bytes <= budget;
+    }
+
+    void CharIndex::Finish()
+    {
+        m_bytes = 0;
+        for (Posting &posting : m_postings)
+        {
+            if (size_t{posting.count} * 100 > m_entries * DENSE_PERCENT)
+            {
+                posting.dense = true;
+                posting.gaps = {};
+            }
+
+            posting.gaps.shrink_to_fit();
+            m_bytes += posting.gaps.capacity();
+        }
+    }
+
+    std::optional<std::vector<uint32_t>> CharIndex::Candidates(std::wstring_view search) const
+    {
+        // Only letters and digits are the same in the regex and the index, the rest are left for the scan
+        std::vector<const Posting *> postings;
+        for (wchar_t ch : search)
+        {
+            std::optional<size_t> posting{ch < 0x80 ? slot(static_cast<wchar_t>(std::towlower(ch))) : std::nullopt};
+            if (!posting.has_value())
+            {
+                continue;
+            }
+
+            const Posting *found{&m_postings[posting.value()]};
+            if (found->count == 0)
+            {
+                return std::vector<uint32_t>{};
+            }
+
+            if (!found->dense && std::find(std::begin(postings), std::end(postings), found) == std::end(postings))
+            {
+                postings.push_back(found);
+            }
+        }
+
+        if (postings.empty())
+        {
+            return std::nullopt;
+        }
+
+        // Starting from the rarest character keeps the candidates few from the start
+        std::sort(std::begin(postings), std::end(postings), [](const Posting *lhs, const Posting *rhs) { return lhs->count < rhs->count; });
+
+        std::vector<uint32_t> candidates;
+        candidates.reserve(postings.front()->count);
+        decode(postings.front()->gaps, [&candidates](uint32_t entry) {
+            candidates.push_back(entry);
+            return true;
+        });
+
+        for (auto itr{std::next(std::begin(postings))}; itr != std::end(postings) && candidates.size() > FEW_CANDIDATES; ++itr)
+        {
+            // Both are in order, so step through the candidates alongside, keeping the ones in this posting too
+            auto keep{std::begin(candidates)};
+            auto candidate{std::begin(candidates)};
+            decode((*itr)->gaps, [&keep, &candidate, end{std::end(candidates)}](uint32_t entry) {
+                while (candidate != end && *candidate < entry)
+                {
+                    ++candidate;
+                }
+
+                if (candidate != end && *candidate == entry)
+                {
+                    *keep++ = entry;
+                    ++candidate;
+                }
+
+                return candidate != end;
+            });
+
+            candidates.erase(keep, std::end(candidates));
+        }
+
+        return candidates;
+    }
+} // namespace yaltl
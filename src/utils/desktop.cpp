@@ -0,0 +1,928 @@
+#include "utils/desktop.h"
+#include "utils/executor.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <unistd.h>
+
+constexpr char CACHE_MAGIC[8]{'Y', 'A', 'L', 'T', 'L', 'D', 'R', 'N'};
+constexpr uint32_t CACHE_VERSION{1};
+
+//! Fewest bytes a cached record takes, the path's size, the mtime and the flags
+constexpr uint64_t MIN_RECORD_BYTES{sizeof(uint32_t) + sizeof(int64_t) + sizeof(uint32_t)};
+
+namespace yaltl
+{
+    namespace desktop
+    {
+        namespace
+        {
+            std::string_view trim(std::string_view str)
+            {
+                const size_t start{str.find_first_not_of(" \t\r")};
+                if (start == std::string_view::npos)
+                {
+                    return {};
+                }
+
+                return str.substr(start, str.find_last_not_of(" \t\r") - start + 1);
+            }
+
+            /**
+             * @brief Splits a string on the delimiter, dropping empty parts
+             *
+             * @param str The string to split
+             * @param delim The delimiter
+             * @return std::vector<std::string> The non-empty parts
+             */
+            std::vector<std::string> split(std::string_view str, char delim)
+            {
+                std::vector<std::string> parts;
+                for (size_t start{}, end{}; start <= str.size(); start = end + 1)
+                {
+                    end = std::min(str.find(delim, start), str.size());
+                    if (end > start)
+                    {
+                        parts.emplace_back(str.substr(start, end - start));
+                    }
+                }
+
+                return parts;
+            }
+
+            /**
+             * @brief Unescapes a desktop entry string value (\s, \n, \t, \r and \\)
+             *
+             * @param value The raw value
+             * @return std::string The unescaped value
+             */
+            std::string unescape(std::string_view value)
+            {
+                std::string result;
+                result.reserve(value.size());
+                for (size_t x{}; x < value.size(); ++x)
+                {
+                    if (value[x] != '\\' || x + 1 == value.size())
+                    {
+                        result += value[x];
+                        continue;
+                    }
+
+                    switch (value[++x])
+                    {
+                    case 's':
+                        result += ' ';
+                        break;
+                    case 'n':
+                        result += '\n';
+                        break;
+                    case 't':
+                        result += '\t';
+                        break;
+                    case 'r':
+                        result += '\r';
+                        break;
+                    default:
+                        result += value[x];
+                        break;
+                    }
+                }
+
+                return result;
+            }
+
+            /**
+             * @brief Splits a desktop entry list (i.e: GNOME;KDE;) respecting escaped semicolons
+             *
+             * @param value The raw value
+             * @return std::vector<std::string> The list items
+             */
+            std::vector<std::string> unescape_list(std::string_view value)
+            {
+                std::vector<std::string> items;
+                std::string current;
+                for (size_t x{}; x < value.size(); ++x)
+                {
+                    if (value[x] == '\\' && x + 1 < value.size() && value[x + 1] == ';')
+                    {
+                        current += ';';
+                        ++x;
+                    }
+                    else if (value[x] == ';')
+                    {
+                        if (!current.empty())
+                        {
+                            items.push_back(unescape(current));
+                        }
+
+                        current.clear();
+                    }
+                    else
+                    {
+                        current += value[x];
+                    }
+                }
+
+                if (!current.empty())
+                {
+                    items.push_back(unescape(current));
+                }
+
+                return items;
+            }
+
+            /**
+             * @brief Gets the locale used for messages from the environment
+             *
+             * @return std::string The locale, i.e: en_US.UTF-8
+             */
+            std::string current_locale()
+            {
+                for (const char *variable : {"LC_ALL", "LC_MESSAGES", "LANG"})
+                {
+                    if (const char *value{std::getenv(variable)}; value && *value)
+                    {
+                        return value;
+                    }
+                }
+
+                return {};
+            }
+
+            /**
+             * @brief Gets the translated key suffixes to look for, best match first
+             *
+             * @param locale The locale, formatted as lang_COUNTRY.ENCODING@MODIFIER
+             * @return std::vector<std::string> i.e: sr_YU@Latn, sr_YU, sr@Latn, sr
+             */
+            std::vector<std::string> locale_candidates(std::string_view locale)
+            {
+                if (locale.empty() || locale == "C" || locale == "POSIX")
+                {
+                    return {};
+                }
+
+                std::string_view modifier;
+                if (size_t at{locale.find('@')}; at != std::string_view::npos)
+                {
+                    modifier = locale.substr(at + 1);
+                    locale = locale.substr(0, at);
+                }
+
+                locale = locale.substr(0, locale.find('.'));
+
+                std::string_view country;
+                std::string_view lang{locale};
+                if (size_t underscore{locale.find('_')}; underscore != std::string_view::npos)
+                {
+                    country = locale.substr(underscore + 1);
+                    lang = locale.substr(0, underscore);
+                }
+
+                std::vector<std::string> candidates;
+                if (!country.empty() && !modifier.empty())
+                {
+                    candidates.push_back(std::string{lang} + "_" + std::string{country} + "@" + std::string{modifier});
+                }
+
+                if (!country.empty())
+                {
+                    candidates.push_back(std::string{lang} + "_" + std::string{country});
+                }
+
+                if (!modifier.empty())
+                {
+                    candidates.push_back(std::string{lang} + "@" + std::string{modifier});
+                }
+
+                candidates.emplace_back(lang);
+
+                return candidates;
+            }
+
+            /**
+             * @brief Checks if a binary can be found, either by absolute path or on $PATH
+             *
+             * @param binary The binary to look for
+             * @return true - Binary was found and is executable
+             */
+            bool find_binary(const std::string &binary)
+            {
+                if (binary.find('/') != std::string::npos)
+                {
+                    return 0 == access(binary.c_str(), X_OK);
+                }
+
+                const char *environmentPath{std::getenv("PATH")};
+                if (!environmentPath)
+                {
+                    return false;
+                }
+
+                const std::vector<std::string> paths{split(environmentPath, ':')};
+                return std::any_of(std::begin(paths), std::end(paths), [&binary](const std::string &path) {
+                    return 0 == access((path + "/" + binary).c_str(), X_OK);
+                });
+            }
+
+            /**
+             * @brief Gets the desktops from $XDG_CURRENT_DESKTOP
+             *
+             * @return const std::vector<std::string>& i.e: {"sway"}
+             */
+            const std::vector<std::string> &current_desktops()
+            {
+                static const std::vector<std::string> desktops{[] {
+                    const char *desktop{std::getenv("XDG_CURRENT_DESKTOP")};
+                    return desktop ? split(desktop, ':') : std::vector<std::string>{};
+                }()};
+
+                return desktops;
+            }
+
+            /**
+             * @brief Gets the XDG data directories in order of precedence
+             *
+             * @return std::vector<std::filesystem::path> $XDG_DATA_HOME followed by $XDG_DATA_DIRS
+             */
+            std::vector<std::filesystem::path> data_dirs()
+            {
+                std::vector<std::filesystem::path> dirs;
+                if (const char *dataHome{std::getenv("XDG_DATA_HOME")}; dataHome && *dataHome)
+                {
+                    dirs.emplace_back(dataHome);
+                }
+                else if (const char *home{std::getenv("HOME")}; home && *home)
+                {
+                    dirs.push_back(std::filesystem::path{home} / ".local" / "share");
+                }
+
+                const char *dataDirs{std::getenv("XDG_DATA_DIRS")};
+                for (std::string &dir : split(dataDirs && *dataDirs ? dataDirs : "/usr/local/share:/usr/share", ':'))
+                {
+                    dirs.emplace_back(std::move(dir));
+                }
+
+                return dirs;
+            }
+
+            std::filesystem::path cache_path()
+            {
+                if (const char *cache{std::getenv("XDG_CACHE_HOME")}; cache && *cache)
+                {
+                    return std::filesystem::path{cache} / "yaltl" / "drun.cache";
+                }
+
+                if (const char *home{std::getenv("HOME")}; home && *home)
+                {
+                    return std::filesystem::path{home} / ".cache" / "yaltl" / "drun.cache";
+                }
+
+                return {};
+            }
+
+            /**
+             * @brief A .desktop file found while scanning the data directories
+             *
+             */
+            struct Candidate
+            {
+                std::string id;
+                std::filesystem::path path;
+                int64_t mtime{};
+            };
+
+            /**
+             * @brief What was parsed from a file the last time it was seen
+             *
+             */
+            struct CacheRecord
+            {
+                int64_t mtime{};
+                std::optional<Application> app;
+            };
+
+            using Cache = std::unordered_map<std::string, CacheRecord>;
+
+            class CacheWriter
+            {
+            public:
+                explicit CacheWriter(std::ofstream &out) : m_out(out)
+                {
+                }
+
+                void write(uint32_t value)
+                {
+                    m_out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+                }
+
+                void write(int64_t value)
+                {
+                    m_out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+                }
+
+                void write(std::string_view str)
+                {
+                    write(static_cast<uint32_t>(str.size()));
+                    m_out.write(str.data(), str.size());
+                }
+
+                void write(const std::vector<std::string> &list)
+                {
+                    write(static_cast<uint32_t>(list.size()));
+                    for (const std::string &str : list)
+                    {
+                        write(str);
+                    }
+                }
+
+            private:
+                std::ofstream &m_out;
+            };
+
+            class CacheReader
+            {
+            public:
+                /**
+                 * @brief Reads a cache file
+                 *
+                 * @param in The file
+                 * @param size The file's size, sizes read from it are checked against what's left so a corrupt cache can't ask for more
+                 */
+                CacheReader(std::ifstream &in, uint64_t size) : m_in(in), m_size(size)
+                {
+                }
+
+                bool read(uint32_t &value)
+                {
+                    return static_cast<bool>(m_in.read(reinterpret_cast<char *>(&value), sizeof(value)));
+                }
+
+                bool read(int64_t &value)
+                {
+                    return static_cast<bool>(m_in.read(reinterpret_cast<char *>(&value), sizeof(value)));
+                }
+
+                bool read(std::string &str)
+                {
+                    uint32_t size{};
+                    if (!read(size) || size > Left())
+                    {
+                        return false;
+                    }
+
+                    str.resize(size);
+                    return static_cast<bool>(m_in.read(str.data(), size));
+                }
+
+                bool read(std::vector<std::string> &list)
+                {
+                    // Each string takes at least its size
+                    uint32_t size{};
+                    if (!read(size) || size > Left() / sizeof(uint32_t))
+                    {
+                        return false;
+                    }
+
+                    list.resize(size);
+                    return std::all_of(std::begin(list), std::end(list), [this](std::string &str) { return read(str); });
+                }
+
+                //! How many bytes are left to read
+                uint64_t Left()
+                {
+                    const std::streamoff pos{m_in.tellg()};
+                    return pos < 0 || static_cast<uint64_t>(pos) > m_size ? 0 : m_size - pos;
+                }
+
+            private:
+                std::ifstream &m_in;
+                uint64_t m_size;
+            };
+
+            /**
+             * @brief Loads the parsed applications from the last run
+             *
+             * @param locale The cache is dropped if it was written for another locale
+             * @return Cache Records keyed by .desktop file path
+             */
+            Cache read_cache(const std::string &locale)
+            {
+                const std::filesystem::path path{cache_path()};
+                if (path.empty())
+                {
+                    return {};
+                }
+
+                std::error_code error;
+                const uint64_t size{std::filesystem::file_size(path, error)};
+                if (error)
+                {
+                    return {};
+                }
+
+                std::ifstream in{path, std::ios::binary};
+                char magic[sizeof(CACHE_MAGIC)]{};
+                uint32_t version{};
+                uint32_t count{};
+                std::string cachedLocale;
+                CacheReader reader{in, size};
+                if (!in.read(magic, sizeof(magic)) || 0 != std::memcmp(magic, CACHE_MAGIC, sizeof(magic)) ||
+                    !reader.read(version) || version != CACHE_VERSION ||
+                    !reader.read(cachedLocale) || cachedLocale != locale ||
+                    !reader.read(count) || count > reader.Left() / MIN_RECORD_BYTES)
+                {
+                    return {};
+                }
+
+                Cache cache;
+                cache.reserve(count);
+                for (uint32_t x{}; x < count; ++x)
+                {
+                    std::string file;
+                    CacheRecord record;
+                    uint32_t flags{};
+                    if (!reader.read(file) || !reader.read(record.mtime) || !reader.read(flags))
+                    {
+                        return {};
+                    }
+
+                    // First bit marks files that had an application in them
+                    if (flags & 1)
+                    {
+                        Application &app{record.app.emplace()};
+                        app.path = file;
+                        app.no_display = flags & 2;
+                        app.hidden = flags & 4;
+                        if (!reader.read(app.name) || !reader.read(app.display_name) || !reader.read(app.description) ||
+                            !reader.read(app.exec) || !reader.read(app.try_exec) || !reader.read(app.icon) ||
+                            !reader.read(app.only_show_in) || !reader.read(app.not_show_in))
+                        {
+                            return {};
+                        }
+                    }
+
+                    cache.emplace(std::move(file), std::move(record));
+                }
+
+                return cache;
+            }
+
+            /**
+             * @brief Saves the parsed applications for the next run
+             *
+             * @param locale The locale the applications were parsed for
+             * @param candidates The files that were found
+             * @param parsed What was parsed from each of the candidates
+             */
+            void write_cache(const std::string &locale, const std::vector<Candidate> &candidates, const std::vector<std::optional<Application>> &parsed)
+            {
+                const std::filesystem::path path{cache_path()};
+                if (path.empty())
+                {
+                    return;
+                }
+
+                std::error_code error;
+                std::filesystem::create_directories(path.parent_path(), error);
+
+                // Write to the side and swap in so a concurrent yaltl never reads a partial cache
+                std::filesystem::path temp{path};
+                temp += "." + std::to_string(getpid());
+                {
+                    std::ofstream out{temp, std::ios::binary | std::ios::trunc};
+                    CacheWriter writer{out};
+                    out.write(CACHE_MAGIC, sizeof(CACHE_MAGIC));
+                    writer.write(CACHE_VERSION);
+                    writer.write(locale);
+                    writer.write(static_cast<uint32_t>(candidates.size()));
+                    for (size_t x{}; x < candidates.size(); ++x)
+                    {
+                        const std::optional<Application> &app{parsed[x]};
+                        writer.write(candidates[x].path.string());
+                        writer.write(candidates[x].mtime);
+                        writer.write(static_cast<uint32_t>(app.has_value() ? (1 | (app->no_display ? 2 : 0) | (app->hidden ? 4 : 0)) : 0));
+                        if (app.has_value())
+                        {
+                            writer.write(app->name);
+                            writer.write(app->display_name);
+                            writer.write(app->description);
+                            writer.write(app->exec);
+                            writer.write(app->try_exec);
+                            writer.write(app->icon);
+                            writer.write(app->only_show_in);
+                            writer.write(app->not_show_in);
+                        }
+                    }
+
+                    if (!out)
+                    {
+                        std::filesystem::remove(temp, error);
+                        return;
+                    }
+                }
+
+                std::filesystem::rename(temp, path, error);
+            }
+
+            /**
+             * @brief Finds all .desktop files, skipping ids already found in a directory with higher precedence
+             *
+             * @return std::vector<Candidate> The files to load
+             */
+            std::vector<Candidate> find_candidates()
+            {
+                std::vector<Candidate> candidates;
+                std::unordered_set<std::string> seen;
+                for (const std::filesystem::path &dir : data_dirs())
+                {
+                    const std::filesystem::path apps{dir / "applications"};
+                    std::error_code error;
+                    for (std::filesystem::recursive_directory_iterator itr{apps, std::filesystem::directory_options::skip_permission_denied | std::filesystem::directory_options::follow_directory_symlink, error}, end;
+                         !error && itr != end;
+                         itr.increment(error))
+                    {
+                        std::error_code fileError;
+                        if (itr->path().extension() != ".desktop" || !itr->is_regular_file(fileError))
+                        {
+                            continue;
+                        }
+
+                        // The desktop file id is the path relative to applications with / replaced by -
+                        std::string id{itr->path().lexically_relative(apps).string()};
+                        std::replace(std::begin(id), std::end(id), '/', '-');
+                        if (!seen.insert(id).second)
+                        {
+                            continue;
+                        }
+
+                        const std::filesystem::file_time_type mtime{itr->last_write_time(fileError)};
+                        if (fileError)
+                        {
+                            continue;
+                        }
+
+                        candidates.push_back({std::move(id), itr->path(), static_cast<int64_t>(mtime.time_since_epoch().count())});
+                    }
+                }
+
+                return candidates;
+            }
+        } // namespace
+
+        std::optional<Application> parse(const std::filesystem::path &path, std::string_view locale)
+        {
+            std::ifstream file{path};
+            if (!file)
+            {
+                return std::nullopt;
+            }
+
+            const std::vector<std::string> locales{locale_candidates(locale)};
+
+            // Lower rank is a better match for the locale, untranslated keys rank after all translations
+            const size_t untranslated{locales.size()};
+            size_t nameRank{untranslated + 1};
+            size_t commentRank{untranslated + 1};
+
+            Application app;
+            app.path = path;
+            std::string type;
+            bool inEntry{};
+            for (std::string line; std::getline(file, line);)
+            {
+                std::string_view view{trim(line)};
+                if (view.empty() || view.front() == '#')
+                {
+                    continue;
+                }
+
+                if (view.front() == '[')
+                {
+                    // Only the [Desktop Entry] group matters, actions and other groups come after it
+                    if (inEntry)
+                    {
+                        break;
+                    }
+
+                    inEntry = view == "[Desktop Entry]";
+                    continue;
+                }
+
+                const size_t equals{view.find('=')};
+                if (!inEntry || equals == std::string_view::npos)
+                {
+                    continue;
+                }
+
+                std::string_view key{trim(view.substr(0, equals))};
+                const std::string_view value{trim(view.substr(equals + 1))};
+
+                size_t rank{untranslated};
+                if (const size_t open{key.find('[')}; open != std::string_view::npos && key.back() == ']')
+                {
+                    const std::string_view keyLocale{key.substr(open + 1, key.size() - open - 2)};
+                    rank = std::distance(std::begin(locales), std::find(std::begin(locales), std::end(locales), keyLocale));
+                    key = key.substr(0, open);
+
+                    // Translation for a different locale
+                    if (rank == untranslated)
+                    {
+                        continue;
+                    }
+                }
+
+                if (key == "Name")
+                {
+                    if (rank == untranslated)
+                    {
+                        app.name = unescape(value);
+                    }
+
+                    if (rank < nameRank)
+                    {
+                        nameRank = rank;
+                        app.display_name = unescape(value);
+                    }
+                }
+                else if (key == "Comment")
+                {
+                    if (rank < commentRank)
+                    {
+                        commentRank = rank;
+                        app.description = unescape(value);
+                    }
+                }
+                else if (rank != untranslated)
+                {
+                    continue;
+                }
+                else if (key == "Type")
+                {
+                    type = value;
+                }
+                else if (key == "Exec")
+                {
+                    app.exec = unescape(value);
+                }
+                else if (key == "TryExec")
+                {
+                    app.try_exec = unescape(value);
+                }
+                else if (key == "Icon")
+                {
+                    app.icon = unescape(value);
+                }
+                else if (key == "OnlyShowIn")
+                {
+                    app.only_show_in = unescape_list(value);
+                }
+                else if (key == "NotShowIn")
+                {
+                    app.not_show_in = unescape_list(value);
+                }
+                else if (key == "NoDisplay")
+                {
+                    app.no_display = value == "true";
+                }
+                else if (key == "Hidden")
+                {
+                    app.hidden = value == "true";
+                }
+            }
+
+            // Hidden entries are kept so they still hide the same id from directories with lower precedence
+            if (app.hidden)
+            {
+                return app;
+            }
+
+            if (type != "Application" || app.name.empty() || app.exec.empty())
+            {
+                return std::nullopt;
+            }
+
+            return app;
+        }
+
+        std::vector<std::string> expand_exec(const Application &app)
+        {
+            // Split into arguments, double quoted arguments may escape ", `, $ and \ .
+            std::vector<std::string> args;
+            std::string current;
+            bool quoted{};
+            bool inArg{};
+            for (size_t x{}; x < app.exec.size(); ++x)
+            {
+                const char ch{app.exec[x]};
+                if (quoted)
+                {
+                    if (ch == '\\' && x + 1 < app.exec.size() && std::strchr("\"`$\\", app.exec[x + 1]))
+                    {
+                        current += app.exec[++x];
+                    }
+                    else if (ch == '"')
+                    {
+                        quoted = false;
+                    }
+                    else
+                    {
+                        current += ch;
+                    }
+                }
+                else if (ch == '"')
+                {
+                    quoted = true;
+                    inArg = true;
+                }
+                else if (ch == ' ' || ch == '\t')
+                {
+                    if (inArg)
+                    {
+                        args.push_back(std::move(current));
+                        current.clear();
+                        inArg = false;
+                    }
+                }
+                else
+                {
+                    current += ch;
+                    inArg = true;
+                }
+            }
+
+            // Unterminated quote, the Exec line is invalid
+            if (quoted)
+            {
+                return {};
+            }
+
+            if (inArg)
+            {
+                args.push_back(std::move(current));
+            }
+
+            std::vector<std::string> argv;
+            argv.reserve(args.size());
+            for (const std::string &arg : args)
+            {
+                if (arg == "%i")
+                {
+                    if (!app.icon.empty())
+                    {
+                        argv.emplace_back("--icon");
+                        argv.push_back(app.icon);
+                    }
+
+                    continue;
+                }
+
+                std::string expanded;
+                bool removed{};
+                for (size_t x{}; x < arg.size(); ++x)
+                {
+                    if (arg[x] != '%' || x + 1 == arg.size())
+                    {
+                        expanded += arg[x];
+                        continue;
+                    }
+
+                    switch (arg[++x])
+                    {
+                    case '%':
+                        expanded += '%';
+                        break;
+                    case 'c':
+                        expanded += app.display_name;
+                        break;
+                    case 'k':
+                        expanded += app.path.string();
+                        break;
+                    default:
+                        // Files, urls and deprecated codes, we never launch with any
+                        removed = true;
+                        break;
+                    }
+                }
+
+                // Drop arguments that were nothing but a field code
+                if (expanded.empty() && removed)
+                {
+                    continue;
+                }
+
+                argv.push_back(std::move(expanded));
+            }
+
+            return argv;
+        }
+
+        bool should_show(const Application &app)
+        {
+            if (app.no_display || app.hidden)
+            {
+                return false;
+            }
+
+            const std::vector<std::string> &desktops{current_desktops()};
+            auto inDesktops{[&desktops](const std::string &desktop) {
+                return std::find(std::begin(desktops), std::end(desktops), desktop) != std::end(desktops);
+            }};
+
+            if (!app.only_show_in.empty() && std::none_of(std::begin(app.only_show_in), std::end(app.only_show_in), inDesktops))
+            {
+                return false;
+            }
+
+            if (std::any_of(std::begin(app.not_show_in), std::end(app.not_show_in), inDesktops))
+            {
+                return false;
+            }
+
+            return app.try_exec.empty() || find_binary(app.try_exec);
+        }
+
+        void load_all(const std::function<void(std::vector<Application> &&)> &on_batch)
+        {
+            const std::string locale{current_locale()};
+            const std::vector<Candidate> candidates{find_candidates()};
+
+            Cache cache{read_cache(locale)};
+            const size_t cachedCount{cache.size()};
+
+            std::vector<std::optional<Application>> parsed(candidates.size());
+            std::vector<size_t> stale;
+            std::vector<Application> cached;
+            for (size_t x{}; x < candidates.size(); ++x)
+            {
+                auto record{cache.find(candidates[x].path.string())};
+                if (record == std::end(cache) || record->second.mtime != candidates[x].mtime)
+                {
+                    stale.push_back(x);
+                    continue;
+                }
+
+                parsed[x] = std::move(record->second.app);
+                if (parsed[x].has_value())
+                {
+                    Application &app{cached.emplace_back(parsed[x].value())};
+                    app.id = candidates[x].id;
+                }
+            }
+
+            if (!cached.empty())
+            {
+                on_batch(std::move(cached));
+            }
+
+            // Parse anything new or modified in parallel chunks
+            if (!stale.empty())
+            {
+                const size_t workers{std::clamp<size_t>(executor::threads(), 1, stale.size())};
+                const size_t chunk{(stale.size() + workers - 1) / workers};
+                std::vector<executor::Job> tasks;
+                tasks.reserve(workers);
+                for (size_t begin{}; begin < stale.size(); begin += chunk)
+                {
+                    tasks.push_back(executor::submit(executor::Lane::Background, [&, begin](std::stop_token) {
+                        std::vector<Application> apps;
+                        for (size_t x{begin}; x < std::min(begin + chunk, stale.size()); ++x)
+                        {
+                            const Candidate &candidate{candidates[stale[x]]};
+                            std::optional<Application> &app{parsed[stale[x]]};
+                            app = parse(candidate.path, locale);
+                            if (app.has_value())
+                            {
+                                apps.push_back(app.value());
+                                apps.back().id = candidate.id;
+                            }
+                        }
+
+                        if (!apps.empty())
+                        {
+                            on_batch(std::move(apps));
+                        }
+                    }));
+                }
+
+                // Chunks no worker got to yet are parsed here instead
+                for (executor::Job &task : tasks)
+                {
+                    task.Wait();
+                }
+            }
+
+            // Only rewrite the cache if a file was added, changed or removed
+            if (!stale.empty() || cachedCount != candidates.size())
+            {
+                write_cache(locale, candidates, parsed);
+            }
+        }
+    } // namespace desktop
+} // namespace yaltl
@@ -0,0 +1,273 @@
+#include "utils/executor.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//! Fewest workers the pool starts with by default, so one long load doesn't hold up everything else
+constexpr size_t MIN_THREADS{2};
+
+namespace yaltl
+{
+    namespace executor
+    {
+        namespace details
+        {
+            enum class Status
+            {
+                Queued,
+                Running,
+                Done
+            };
+
+            struct State
+            {
+                std::function<void(std::stop_token)> work;
+                std::stop_source stop;
+                std::atomic<Status> status{Status::Queued};
+            };
+
+            /**
+             * @brief Runs the work unless another thread already took it
+             *
+             * @param state The work
+             * @return true - The work was taken by this thread, and has finished or was skipped
+             */
+            static bool run(State &state)
+            {
+                Status expected{Status::Queued};
+                if (!state.status.compare_exchange_strong(expected, Status::Running))
+                {
+                    return false;
+                }
+
+                if (!state.stop.stop_requested())
+                {
+                    try
+                    {
+                        state.work(state.stop.get_token());
+                    }
+                    catch (...)
+                    {
+                        // Nothing reads a result, dropped the same as an unread std::future would
+                    }
+                }
+
+                // Let go of what the work captured before anything waiting on it carries on
+                state.work = nullptr;
+                state.status.store(Status::Done);
+                state.status.notify_all();
+                return true;
+            }
+        } // namespace details
+
+        namespace
+        {
+            using Shared = std::shared_ptr<details::State>;
+
+            constexpr size_t LANES{static_cast<size_t>(Lane::Background) + 1};
+
+            struct Queue
+            {
+                std::mutex lock;
+                std::deque<Shared> jobs;
+            };
+
+            using Queues = std::array<Queue, LANES>;
+
+            class Pool;
+
+            //! The pool and worker the calling thread belongs to, if any
+            thread_local Pool *t_pool{};
+            thread_local size_t t_worker{};
+
+            class Pool
+            {
+            public:
+                explicit Pool(size_t threads) : m_local(threads)
+                {
+                    m_workers.reserve(threads);
+                    for (size_t x{}; x < threads; ++x)
+                    {
+                        m_workers.emplace_back([this, x](std::stop_token stop) { Work(x, stop); });
+                    }
+                }
+
+                void Push(Lane lane, Shared job)
+                {
+                    // Workers keep what they submit to themselves, the rest is shared
+                    Queue &queue{t_pool == this ? m_local[t_worker][static_cast<size_t>(lane)] : m_shared[static_cast<size_t>(lane)]};
+                    {
+                        std::scoped_lock lock{queue.lock};
+                        queue.jobs.push_back(std::move(job));
+                    }
+
+                    {
+                        std::scoped_lock lock{m_sleep};
+                        ++m_queued;
+                    }
+
+                    m_wake.notify_one();
+                }
+
+            private:
+                static Shared Pop(Queue &queue, bool newest)
+                {
+                    std::scoped_lock lock{queue.lock};
+                    if (queue.jobs.empty())
+                    {
+                        return nullptr;
+                    }
+
+                    Shared job{newest ? std::move(queue.jobs.back()) : std::move(queue.jobs.front())};
+                    newest ? queue.jobs.pop_back() : queue.jobs.pop_front();
+                    return job;
+                }
+
+                Shared Take(size_t self)
+                {
+                    for (size_t lane{}; lane < LANES; ++lane)
+                    {
+                        // Own work newest first while it's still in cache, then shared work, then the oldest work of others
+                        if (Shared job{Pop(m_local[self][lane], true)})
+                        {
+                            return job;
+                        }
+
+                        if (Shared job{Pop(m_shared[lane], false)})
+                        {
+                            return job;
+                        }
+
+                        for (size_t x{1}; x < m_local.size(); ++x)
+                        {
+                            if (Shared job{Pop(m_local[(self + x) % m_local.size()][lane], false)})
+                            {
+                                return job;
+                            }
+                        }
+                    }
+
+                    return nullptr;
+                }
+
+                void Work(size_t self, std::stop_token stop)
+                {
+                    t_pool = this;
+                    t_worker = self;
+                    while (true)
+                    {
+                        {
+                            std::unique_lock lock{m_sleep};
+                            if (!m_wake.wait(lock, stop, [this] { return m_queued > 0; }))
+                            {
+                                return;
+                            }
+                        }
+
+                        // Another worker may have beaten this one to it, in which case look again
+                        if (Shared job{Take(self)})
+                        {
+                            m_queued.fetch_sub(1);
+
+                            // Jobs that were waited on may already have run on the waiting thread
+                            details::run(*job);
+                        }
+                    }
+                }
+
+            private:
+                std::vector<Queues> m_local;
+                Queues m_shared;
+
+                std::mutex m_sleep;
+                std::condition_variable_any m_wake;
+                std::atomic<size_t> m_queued{};
+
+                //! Declared last so the workers stop before the queues are destroyed
+                std::vector<std::jthread> m_workers;
+            };
+
+            std::atomic<size_t> g_threads{};
+
+            Pool &pool()
+            {
+                static Pool pool{threads()};
+                return pool;
+            }
+        } // namespace
+
+        Job::Job(std::shared_ptr<details::State> state) : m_state(std::move(state))
+        {
+        }
+
+        Job::~Job()
+        {
+            Cancel();
+            Wait();
+        }
+
+        Job &Job::operator=(Job &&other) noexcept
+        {
+            if (this != &other)
+            {
+                Cancel();
+                Wait();
+                m_state = std::move(other.m_state);
+            }
+
+            return *this;
+        }
+
+        void Job::Cancel()
+        {
+            if (m_state)
+            {
+                m_state->stop.request_stop();
+            }
+        }
+
+        void Job::Wait()
+        {
+            if (!m_state || details::run(*m_state))
+            {
+                return;
+            }
+
+            for (details::Status status{m_state->status.load()}; status != details::Status::Done; status = m_state->status.load())
+            {
+                m_state->status.wait(status);
+            }
+        }
+
+        bool Job::Done() const
+        {
+            return m_state && m_state->status.load() == details::Status::Done;
+        }
+
+        void configure(size_t threads)
+        {
+            g_threads = threads;
+        }
+
+        size_t threads()
+        {
+            const size_t configured{g_threads};
+            return configured > 0 ? configured : std::max<size_t>(std::thread::hardware_concurrency(), MIN_THREADS);
+        }
+
+        Job submit(Lane lane, std::function<void(std::stop_token)> work)
+        {
+            auto state{std::make_shared<details::State>()};
+            state->work = std::move(work);
+            pool().Push(lane, state);
+
+            return Job{std::move(state)};
+        }
+    } // namespace executor
+} // namespace yaltl
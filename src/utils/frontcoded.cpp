@@ -0,0 +1,127 @@
+#include "utils/frontcoded.h"
+#include "utils/utf8.h"
+
+#include <algorithm>
+
+namespace yaltl
+{
+    namespace
+    {
+        void encode(std::vector<char> &out, size_t value)
+        {
+            for (; value >= 0x80; value >>= 7)
+            {
+                out.push_back(static_cast<char>(value | 0x80));
+            }
+
+            out.push_back(static_cast<char>(value));
+        }
+
+        size_t decode(const char *&in)
+        {
+            size_t value{};
+            for (size_t shift{};; shift += 7)
+            {
+                const uint8_t byte{static_cast<uint8_t>(*in++)};
+                value |= static_cast<size_t>(byte & 0x7f) << shift;
+                if (!(byte & 0x80))
+                {
+                    return value;
+                }
+            }
+        }
+
+        //! Walks the lines of a block in order
+        class Cursor
+        {
+        public:
+            Cursor(const std::vector<char> &data, const std::vector<uint64_t> &blocks) : m_data(data), m_blocks(blocks)
+            {
+            }
+
+            //! Decodes up to a line, starting over at its block unless it's further along the current one
+            std::wstring_view Seek(size_t index)
+            {
+                const size_t block{index / FrontCoded::BLOCK_LINES};
+                if (block != m_block || index < m_next)
+                {
+                    m_block = block;
+                    m_next = block * FrontCoded::BLOCK_LINES;
+                    m_in = m_data.data() + m_blocks[block];
+                }
+
+                for (; m_next <= index; ++m_next)
+                {
+                    const size_t shared{decode(m_in)};
+                    const size_t length{decode(m_in)};
+                    m_line.resize(shared);
+                    m_line.append(m_in, length);
+                    m_in += length;
+                }
+
+                utf8::widen(m_line, m_wide);
+                return m_wide;
+            }
+
+        private:
+            const std::vector<char> &m_data;
+            const std::vector<uint64_t> &m_blocks;
+
+            size_t m_block{SIZE_MAX};
+            size_t m_next{};
+            const char *m_in{};
+            std::string m_line;
+            std::wstring m_wide;
+        };
+    } // namespace
+
+    void FrontCoded::Append(std::string_view line)
+    {
+        size_t shared{};
+        if (m_size % BLOCK_LINES == 0)
+        {
+            m_blocks.push_back(m_data.size());
+        }
+        else
+        {
+            shared = std::distance(std::begin(line), std::mismatch(std::begin(line), std::end(line), std::begin(m_last), std::end(m_last)).first);
+        }
+
+        encode(m_data, shared);
+        encode(m_data, line.size() - shared);
+        m_data.insert(std::end(m_data), std::begin(line) + shared, std::end(line));
+        m_last.assign(line);
+        ++m_size;
+    }
+
+    void FrontCoded::Shrink()
+    {
+        m_data.shrink_to_fit();
+        m_blocks.shrink_to_fit();
+        m_last = std::string{};
+    }
+
+    void FrontCoded::Scan(size_t begin, size_t end, const Visit &visit) const
+    {
+        Cursor cursor{m_data, m_blocks};
+        for (size_t index{begin}; index < std::min(end, m_size); ++index)
+        {
+            if (!visit(index, cursor.Seek(index)))
+            {
+                return;
+            }
+        }
+    }
+
+    void FrontCoded::Lines(std::span<const uint32_t> indexes, const Visit &visit) const
+    {
+        Cursor cursor{m_data, m_blocks};
+        for (uint32_t index : indexes)
+        {
+            if (index >= m_size || !visit(index, cursor.Seek(index)))
+            {
+                return;
+            }
+        }
+    }
+} // namespace yaltl
@@ -0,0 +1,96 @@
+#include "utils/histogram.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <sstream>
+
+namespace yaltl
+{
+    size_t Histogram::Index(uint64_t value)
+    {
+        value = std::min(value, (uint64_t{1} << MAX_BITS) - 1);
+        if (value < (uint64_t{1} << SUB_BITS))
+        {
+            return static_cast<size_t>(value);
+        }
+
+        // The top SUB_BITS + 1 bits pick the bucket, the rest is how far it's shifted
+        const unsigned shift{static_cast<unsigned>(std::bit_width(value)) - SUB_BITS - 1};
+
+        return ((shift + 1) << SUB_BITS) + static_cast<size_t>((value >> shift) - (uint64_t{1} << SUB_BITS));
+    }
+
+    uint64_t Histogram::Highest(size_t index)
+    {
+        if (index < (size_t{1} << SUB_BITS))
+        {
+            return index;
+        }
+
+        const unsigned shift{static_cast<unsigned>(index >> SUB_BITS) - 1};
+        const uint64_t lowest{((index & ((size_t{1} << SUB_BITS) - 1)) + (uint64_t{1} << SUB_BITS)) << shift};
+
+        return lowest + (uint64_t{1} << shift) - 1;
+    }
+
+    void Histogram::Record(uint64_t value)
+    {
+        ++m_buckets[Index(value)];
+        ++m_count;
+        m_total += value;
+        m_min = std::min(m_min, value);
+        m_max = std::max(m_max, value);
+    }
+
+    uint64_t Histogram::Percentile(double percentile) const
+    {
+        if (0 == m_count)
+        {
+            return 0;
+        }
+
+        const uint64_t rank{std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(percentile / 100 * m_count)))};
+        uint64_t seen{};
+        for (size_t index{}; index < BUCKETS; ++index)
+        {
+            seen += m_buckets[index];
+            if (seen >= rank)
+            {
+                // The bucket's bound can overshoot what was actually seen
+                return std::min(Highest(index), m_max);
+            }
+        }
+
+        return m_max;
+    }
+
+    std::string Histogram::Json() const
+    {
+        std::ostringstream json;
+        json << "{\"count\":" << m_count
+             << ",\"min\":" << Min()
+             << ",\"max\":" << m_max
+             << ",\"mean\":" << static_cast<uint64_t>(Mean())
+             << ",\"p50\":" << Percentile(50)
+             << ",\"p90\":" << Percentile(90)
+             << ",\"p99\":" << Percentile(99)
+             << ",\"p999\":" << Percentile(99.9)
+             << ",\"buckets\":[";
+
+        // Only buckets with something in them, as [highest value, count]
+        bool first{true};
+        for (size_t index{}; index < BUCKETS; ++index)
+        {
+            if (m_buckets[index] > 0)
+            {
+                json << (first ? "" : ",") << '[' << Highest(index) << ',' << m_buckets[index] << ']';
+                first = false;
+            }
+        }
+
+        json << "]}";
+
+        return json.str();
+    }
+} // namespace yaltl
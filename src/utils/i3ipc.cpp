@@ -0,0 +1,206 @@
+#include "utils/i3ipc.h"
+
+#include "utils/json.h"
+#include "utils/subprocess.h"
+#include "utils/trace.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+constexpr std::string_view IPC_MAGIC{"i3-ipc"};
+
+namespace yaltl
+{
+    namespace i3
+    {
+        namespace
+        {
+            /**
+             * @brief Finds the IPC socket
+             * 
+             * @return std::string The path to the socket, empty if not running under i3 or sway
+             */
+            std::string socket_path()
+            {
+                for (const char *variable : {"SWAYSOCK", "I3SOCK"})
+                {
+                    if (const char *path{std::getenv(variable)}; path && *path)
+                    {
+                        return path;
+                    }
+                }
+
+                subprocess::Options options;
+                options.argv = {"i3", "--get-socketpath"};
+                options.timeout = std::chrono::seconds{1};
+
+                const subprocess::Output output{subprocess::run(std::move(options))};
+                return output.status == 0 && !output.lines.empty() ? std::string{output.lines[0]} : std::string{};
+            }
+
+            bool write_all(int fd, const char *data, size_t size)
+            {
+                while (size > 0)
+                {
+                    const ssize_t written{write(fd, data, size)};
+                    if (written < 0 && errno == EINTR)
+                    {
+                        continue;
+                    }
+
+                    if (written <= 0)
+                    {
+                        return false;
+                    }
+
+                    data += written;
+                    size -= written;
+                }
+
+                return true;
+            }
+
+            bool read_all(int fd, char *data, size_t size)
+            {
+                while (size > 0)
+                {
+                    const ssize_t count{read(fd, data, size)};
+                    if (count < 0 && errno == EINTR)
+                    {
+                        continue;
+                    }
+
+                    if (count <= 0)
+                    {
+                        return false;
+                    }
+
+                    data += count;
+                    size -= count;
+                }
+
+                return true;
+            }
+        } // namespace
+
+        Connection::Connection()
+        {
+            trace::Span span{"i3::Connection"};
+            const std::string path{socket_path()};
+            sockaddr_un address{};
+            if (path.empty() || path.size() >= sizeof(address.sun_path))
+            {
+                return;
+            }
+
+            m_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (m_fd < 0)
+            {
+                return;
+            }
+
+            address.sun_family = AF_UNIX;
+            std::memcpy(address.sun_path, path.c_str(), path.size());
+            if (0 != connect(m_fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)))
+            {
+                close(m_fd);
+                m_fd = -1;
+            }
+        }
+
+        Connection::~Connection()
+        {
+            if (m_fd >= 0)
+            {
+                close(m_fd);
+            }
+        }
+
+        bool Connection::Send(Message type, std::string_view payload)
+        {
+            // Header is the magic string followed by the payload length and message type in native byte order
+            std::string message{IPC_MAGIC};
+            const uint32_t header[]{static_cast<uint32_t>(payload.size()), static_cast<uint32_t>(type)};
+            message.append(reinterpret_cast<const char *>(header), sizeof(header));
+            message.append(payload);
+
+            return Connected() && write_all(m_fd, message.data(), message.size());
+        }
+
+        bool Connection::Read(uint32_t &type, std::string &payload)
+        {
+            char header[IPC_MAGIC.size() + 2 * sizeof(uint32_t)]{};
+            if (!Connected() || !read_all(m_fd, header, sizeof(header)) || std::string_view{header, IPC_MAGIC.size()} != IPC_MAGIC)
+            {
+                return false;
+            }
+
+            uint32_t size{};
+            std::memcpy(&size, header + IPC_MAGIC.size(), sizeof(size));
+            std::memcpy(&type, header + IPC_MAGIC.size() + sizeof(size), sizeof(type));
+
+            payload.resize(size);
+            return read_all(m_fd, payload.data(), size);
+        }
+
+        std::optional<std::string> Connection::Request(Message type, std::string_view payload)
+        {
+            if (!Send(type, payload))
+            {
+                return std::nullopt;
+            }
+
+            uint32_t replyType{};
+            std::string reply;
+            if (!Read(replyType, reply) || replyType != static_cast<uint32_t>(type))
+            {
+                return std::nullopt;
+            }
+
+            return reply;
+        }
+
+        bool Connection::Command(std::string_view command)
+        {
+            std::optional<std::string> reply{Request(Message::RunCommand, command)};
+            if (!reply.has_value())
+            {
+                return false;
+            }
+
+            // Reply is an array with one result per command, i.e: [{"success":true}]
+            bool succeeded{true};
+            json::Scanner scanner{reply.value()};
+            const bool parsed{scanner.Array([&scanner, &succeeded] {
+                return scanner.Object([&scanner, &succeeded](std::string_view key) {
+                    if (key != "success")
+                    {
+                        return scanner.Skip();
+                    }
+
+                    bool success{};
+                    if (!scanner.Bool(success))
+                    {
+                        return false;
+                    }
+
+                    succeeded = succeeded && success;
+                    return true;
+                });
+            })};
+
+            return parsed && succeeded;
+        }
+
+        bool Connection::Subscribe(std::string_view events)
+        {
+            std::optional<std::string> reply{Request(Message::Subscribe, events)};
+            return reply.has_value() && reply->find("true") != std::string::npos;
+        }
+    } // namespace i3
+} // namespace yaltl
@@ -0,0 +1,322 @@
+#include "utils/json.h"
+
+namespace yaltl
+{
+    namespace json
+    {
+        namespace
+        {
+            void append_utf8(std::string &out, uint32_t code)
+            {
+                if (code < 0x80)
+                {
+                    out += static_cast<char>(code);
+                }
+                else if (code < 0x800)
+                {
+                    out += static_cast<char>(0xC0 | (code >> 6));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                }
+                else if (code < 0x10000)
+                {
+                    out += static_cast<char>(0xE0 | (code >> 12));
+                    out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                }
+                else
+                {
+                    out += static_cast<char>(0xF0 | (code >> 18));
+                    out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+                    out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                }
+            }
+
+            bool parse_hex(std::string_view hex, uint32_t &out)
+            {
+                out = 0;
+                for (char ch : hex)
+                {
+                    out <<= 4;
+                    if (ch >= '0' && ch <= '9')
+                    {
+                        out |= ch - '0';
+                    }
+                    else if (ch >= 'a' && ch <= 'f')
+                    {
+                        out |= ch - 'a' + 10;
+                    }
+                    else if (ch >= 'A' && ch <= 'F')
+                    {
+                        out |= ch - 'A' + 10;
+                    }
+                    else
+                    {
+                        return false;
+                    }
+                }
+
+                return true;
+            }
+        } // namespace
+
+        void Scanner::SkipSpace()
+        {
+            while (m_pos < m_json.size() && (m_json[m_pos] == ' ' || m_json[m_pos] == '\n' || m_json[m_pos] == '\r' || m_json[m_pos] == '\t'))
+            {
+                ++m_pos;
+            }
+        }
+
+        bool Scanner::Consume(char ch)
+        {
+            SkipSpace();
+            if (m_pos < m_json.size() && m_json[m_pos] == ch)
+            {
+                ++m_pos;
+                return true;
+            }
+
+            return false;
+        }
+
+        bool Scanner::RawString(std::string_view &out)
+        {
+            if (!Consume('"'))
+            {
+                return false;
+            }
+
+            const size_t start{m_pos};
+            while (m_pos < m_json.size() && m_json[m_pos] != '"')
+            {
+                m_pos += m_json[m_pos] == '\\' ? 2 : 1;
+            }
+
+            if (m_pos >= m_json.size())
+            {
+                return false;
+            }
+
+            out = m_json.substr(start, m_pos - start);
+            ++m_pos;
+
+            return true;
+        }
+
+        bool Scanner::String(std::string &out)
+        {
+            std::string_view raw;
+            if (!RawString(raw))
+            {
+                return false;
+            }
+
+            out.clear();
+            out.reserve(raw.size());
+            for (size_t x{}; x < raw.size(); ++x)
+            {
+                if (raw[x] != '\\')
+                {
+                    out += raw[x];
+                    continue;
+                }
+
+                switch (raw[++x])
+                {
+                case 'b':
+                    out += '\b';
+                    break;
+                case 'f':
+                    out += '\f';
+                    break;
+                case 'n':
+                    out += '\n';
+                    break;
+                case 'r':
+                    out += '\r';
+                    break;
+                case 't':
+                    out += '\t';
+                    break;
+                case 'u':
+                {
+                    uint32_t code{};
+                    if (x + 4 >= raw.size() || !parse_hex(raw.substr(x + 1, 4), code))
+                    {
+                        return false;
+                    }
+
+                    x += 4;
+
+                    // Characters outside the BMP come as a surrogate pair
+                    uint32_t low{};
+                    if (code >= 0xD800 && code < 0xDC00 && x + 6 < raw.size() && raw[x + 1] == '\\' && raw[x + 2] == 'u' &&
+                        parse_hex(raw.substr(x + 3, 4), low) && low >= 0xDC00 && low < 0xE000)
+                    {
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        x += 6;
+                    }
+
+                    append_utf8(out, code);
+                    break;
+                }
+                default:
+                    // \" \\ and \/
+                    out += raw[x];
+                    break;
+                }
+            }
+
+            return true;
+        }
+
+        bool Scanner::Number(uint64_t &out)
+        {
+            SkipSpace();
+            const size_t start{m_pos};
+            out = 0;
+            while (m_pos < m_json.size() && m_json[m_pos] >= '0' && m_json[m_pos] <= '9')
+            {
+                out = out * 10 + (m_json[m_pos++] - '0');
+            }
+
+            return m_pos > start;
+        }
+
+        bool Scanner::Bool(bool &out)
+        {
+            SkipSpace();
+            if (m_json.substr(m_pos).starts_with("true"))
+            {
+                m_pos += 4;
+                out = true;
+                return true;
+            }
+
+            if (m_json.substr(m_pos).starts_with("false"))
+            {
+                m_pos += 5;
+                out = false;
+                return true;
+            }
+
+            return false;
+        }
+
+        bool Scanner::Null()
+        {
+            SkipSpace();
+            if (m_json.substr(m_pos).starts_with("null"))
+            {
+                m_pos += 4;
+                return true;
+            }
+
+            return false;
+        }
+
+        bool Scanner::Skip()
+        {
+            SkipSpace();
+            if (m_pos >= m_json.size())
+            {
+                return false;
+            }
+
+            const char first{m_json[m_pos]};
+            if (first == '"')
+            {
+                std::string_view ignored;
+                return RawString(ignored);
+            }
+
+            if (first != '{' && first != '[')
+            {
+                // Number, true, false or null, run to the next delimiter
+                const size_t start{m_pos};
+                while (m_pos < m_json.size() && m_json[m_pos] != ',' && m_json[m_pos] != '}' && m_json[m_pos] != ']' &&
+                       m_json[m_pos] != ' ' && m_json[m_pos] != '\n' && m_json[m_pos] != '\r' && m_json[m_pos] != '\t')
+                {
+                    ++m_pos;
+                }
+
+                return m_pos > start;
+            }
+
+            // Objects and arrays only need their brackets balanced, minding brackets in strings
+            size_t depth{};
+            while (m_pos < m_json.size())
+            {
+                const char ch{m_json[m_pos]};
+                if (ch == '"')
+                {
+                    std::string_view ignored;
+                    if (!RawString(ignored))
+                    {
+                        return false;
+                    }
+
+                    continue;
+                }
+
+                ++m_pos;
+                if (ch == '{' || ch == '[')
+                {
+                    ++depth;
+                }
+                else if ((ch == '}' || ch == ']') && 0 == --depth)
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        std::string quote(std::string_view text)
+        {
+            constexpr char HEX[]{"0123456789abcdef"};
+
+            std::string quoted;
+            quoted.reserve(text.size() + 2);
+            quoted += '"';
+            for (char ch : text)
+            {
+                switch (ch)
+                {
+                case '"':
+                    quoted += "\\\"";
+                    break;
+                case '\\':
+                    quoted += "\\\\";
+                    break;
+                case '\n':
+                    quoted += "\\n";
+                    break;
+                case '\r':
+                    quoted += "\\r";
+                    break;
+                case '\t':
+                    quoted += "\\t";
+                    break;
+                default:
+                    if (static_cast<unsigned char>(ch) < 0x20)
+                    {
+                        quoted += "\\u00";
+                        quoted += HEX[ch >> 4];
+                        quoted += HEX[ch & 0xF];
+                    }
+                    else
+                    {
+                        quoted += ch;
+                    }
+                }
+            }
+
+            quoted += '"';
+
+            return quoted;
+        }
+    } // namespace json
+} // namespace yaltl
@@ -0,0 +1,250 @@
+#include "utils/matcher.h"
+#include "utils/executor.h"
+#include "utils/regex.h"
+#include "utils/stats.h"
+
+#include "mtl/details/istring.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <span>
+#include <tuple>
+
+//! Fewest entries worth handing to another worker, below this the scan is quicker than waking one up
+constexpr size_t SCAN_CHUNK{8192};
+
+namespace yaltl
+{
+    namespace matcher
+    {
+        namespace
+        {
+            //! A line that matched, kept instead of an entry until it's known to be among the best
+            struct Hit
+            {
+                uint32_t index{};
+
+                //! Where the fuzz is in the line
+                uint32_t offset{};
+                uint32_t length{};
+                bool exact{};
+
+                //! Exact matches first, then by fuzz, then in input order so the ranking is the same every time
+                bool operator<(const Hit &other) const
+                {
+                    return std::make_tuple(!exact, length, index) < std::make_tuple(!other.exact, other.length, other.index);
+                }
+            };
+
+            //! Drops all but the best hits
+            void keep(std::vector<Hit> &hits, size_t limit)
+            {
+                if (hits.size() > limit)
+                {
+                    std::nth_element(std::begin(hits), std::begin(hits) + limit, std::end(hits));
+                    hits.resize(limit);
+                }
+            }
+        } // namespace
+
+        std::wstring_view search_text(const std::wstring &search, bool firstWordOnly)
+        {
+            if (!firstWordOnly)
+            {
+                return search;
+            }
+
+            if (size_t pos{search.find(L' ')}; pos != std::wstring::npos)
+            {
+                return std::wstring_view(search.c_str(), pos);
+            }
+
+            return search;
+        }
+
+        std::vector<FuzzyResult> rank(Entries::const_iterator begin, Entries::const_iterator end, const std::wstring &search, bool firstWordOnly, size_t &exact)
+        {
+            std::vector<FuzzyResult> ranked;
+            ranked.reserve(std::distance(begin, end));
+            std::transform(begin, end, std::back_inserter(ranked), [](const std::shared_ptr<Entry> &ptr)
+                           { return FuzzyResult{ptr, std::nullopt}; });
+
+            std::wstring_view realSearch{search_text(search, firstWordOnly)};
+            if (realSearch.empty())
+            {
+                exact = ranked.size();
+                return ranked;
+            }
+
+            std::optional<stats::Timer> timer{std::in_place, stats::Stage::Compile};
+            regex::regex_t regex{regex::build_regex(realSearch)};
+            timer.emplace(stats::Stage::Scan);
+            auto scan{[&regex](const FuzzyResult &fuzzy)
+                      {
+                auto &criteria = fuzzy.result->criteria;
+                std::optional<std::wstring_view> fuzzFactor;
+                if (criteria.has_value())
+                {
+                    std::vector<std::optional<std::wstring_view>> fuzz;
+                    fuzz.reserve(criteria.value().size());
+                    std::transform(std::begin(criteria.value()), std::end(criteria.value()), std::back_inserter(fuzz), [&regex](const std::wstring &critter) {
+                        return regex::fuzzy_find(critter, regex);
+                    });
+
+                    fuzz.erase(std::remove(std::begin(fuzz), std::end(fuzz), std::nullopt), std::end(fuzz));
+                    if (!fuzz.empty())
+                    {
+                        fuzzFactor = fuzz[0];
+                    }
+                }
+                else
+                {
+                    fuzzFactor = regex::fuzzy_find(fuzzy.result->display, regex);
+                }
+
+                return FuzzyResult{fuzzy.result, fuzzFactor}; }};
+
+            // Large scans are split over the interactive lane, this thread scans the first chunk and whatever no worker picked up
+            const size_t chunks{std::clamp<size_t>(ranked.size() / SCAN_CHUNK, 1, executor::threads() + 1)};
+            const size_t chunk{(ranked.size() + chunks - 1) / chunks};
+            std::vector<executor::Job> scans;
+            scans.reserve(chunks - 1);
+            for (size_t begin{chunk}; begin < ranked.size(); begin += chunk)
+            {
+                scans.push_back(executor::submit(executor::Lane::Interactive, [&ranked, &scan, begin, end{std::min(begin + chunk, ranked.size())}](std::stop_token) {
+                    std::transform(std::begin(ranked) + begin, std::begin(ranked) + end, std::begin(ranked) + begin, scan);
+                }));
+            }
+
+            std::transform(std::begin(ranked), std::begin(ranked) + std::min(chunk, ranked.size()), std::begin(ranked), scan);
+            for (executor::Job &job : scans)
+            {
+                job.Wait();
+            }
+
+            timer.emplace(stats::Stage::Rank);
+            std::sort(std::begin(ranked), std::end(ranked));
+
+            ranked.erase(std::remove_if(std::begin(ranked), std::end(ranked), [](const FuzzyResult &fuzzy)
+                                        { return !fuzzy.match.has_value(); }),
+                         std::end(ranked));
+
+            auto inexact{std::stable_partition(std::begin(ranked), std::end(ranked), [&search](const FuzzyResult &fuzzy)
+                                               { return mtl::string::ifind(fuzzy.result->display, search) != std::wstring::npos; })};
+            exact = std::distance(std::begin(ranked), inexact);
+
+            return ranked;
+        }
+
+        std::vector<FuzzyResult> rank(const FrontCoded &lines, const std::optional<std::vector<uint32_t>> &candidates, const std::wstring &search, bool firstWordOnly, size_t limit, size_t &exact)
+        {
+            const size_t total{candidates.has_value() ? candidates->size() : lines.Size()};
+            std::wstring_view realSearch{search_text(search, firstWordOnly)};
+            std::vector<Hit> hits;
+            if (realSearch.empty())
+            {
+                // Everything matches, so the first lines as they came
+                hits.reserve(std::min(limit, total));
+                for (size_t x{}; x < std::min(limit, total); ++x)
+                {
+                    hits.push_back(Hit{candidates.has_value() ? candidates.value()[x] : static_cast<uint32_t>(x), 0, 0, true});
+                }
+            }
+            else
+            {
+                std::optional<stats::Timer> timer{std::in_place, stats::Stage::Compile};
+                regex::regex_t regex{regex::build_regex(realSearch)};
+                timer.emplace(stats::Stage::Scan);
+
+                const size_t chunks{std::clamp<size_t>(total / SCAN_CHUNK, 1, executor::threads() + 1)};
+                const size_t chunk{(total + chunks - 1) / chunks};
+                std::vector<std::vector<Hit>> found(chunks);
+                auto scan{[&lines, &candidates, &search, &regex, &found, total, chunk, limit](size_t part) {
+                    std::vector<Hit> &hits{found[part]};
+                    std::wstring exactLine;
+                    const FrontCoded::Visit visit{[&](size_t index, std::wstring_view line) {
+                        if (std::optional<std::wstring_view> fuzz{regex::fuzzy_find(line, regex)}; fuzz.has_value())
+                        {
+                            exactLine.assign(line);
+                            hits.push_back(Hit{static_cast<uint32_t>(index), static_cast<uint32_t>(fuzz->data() - line.data()), static_cast<uint32_t>(fuzz->size()),
+                                               mtl::string::ifind(exactLine, search) != std::wstring::npos});
+
+                            // Only the best are made entries, so a search matching most lines doesn't hold on to all of them
+                            if (hits.size() / 2 >= limit)
+                            {
+                                keep(hits, limit);
+                            }
+                        }
+
+                        return true;
+                    }};
+
+                    const size_t begin{std::min(part * chunk, total)};
+                    const size_t end{std::min(begin + chunk, total)};
+                    if (candidates.has_value())
+                    {
+                        lines.Lines(std::span<const uint32_t>{candidates.value()}.subspan(begin, end - begin), visit);
+                    }
+                    else
+                    {
+                        lines.Scan(begin, end, visit);
+                    }
+                }};
+
+                // Split the same as entries, each chunk decoding its own blocks
+                std::vector<executor::Job> scans;
+                scans.reserve(chunks - 1);
+                for (size_t part{1}; part < chunks; ++part)
+                {
+                    scans.push_back(executor::submit(executor::Lane::Interactive, [&scan, part](std::stop_token) { scan(part); }));
+                }
+
+                scan(0);
+                for (executor::Job &job : scans)
+                {
+                    job.Wait();
+                }
+
+                timer.emplace(stats::Stage::Rank);
+                for (std::vector<Hit> &part : found)
+                {
+                    hits.insert(std::end(hits), std::begin(part), std::end(part));
+                    keep(hits, limit);
+                }
+            }
+
+            std::sort(std::begin(hits), std::end(hits));
+            exact = std::distance(std::begin(hits), std::partition_point(std::begin(hits), std::end(hits), [](const Hit &hit) { return hit.exact; }));
+
+            // Decoded in input order so each block is decoded once, then put back in rank order
+            std::vector<std::pair<uint32_t, size_t>> order;
+            order.reserve(hits.size());
+            for (size_t x{}; x < hits.size(); ++x)
+            {
+                order.emplace_back(hits[x].index, x);
+            }
+
+            std::sort(std::begin(order), std::end(order));
+            std::vector<uint32_t> indexes;
+            indexes.reserve(order.size());
+            std::transform(std::begin(order), std::end(order), std::back_inserter(indexes), [](const auto &line) { return line.first; });
+
+            std::vector<FuzzyResult> ranked(hits.size());
+            auto next{std::begin(order)};
+            lines.Lines(indexes, [&ranked, &hits, &next, matched{!realSearch.empty()}](size_t, std::wstring_view line) {
+                const Hit &hit{hits[next->second]};
+                FuzzyResult &result{ranked[next->second]};
+                result.result = std::make_shared<Entry>(std::wstring{line});
+                if (matched)
+                {
+                    result.match = std::wstring_view{result.result->display}.substr(hit.offset, hit.length);
+                }
+
+                ++next;
+                return true;
+            });
+
+            return ranked;
+        }
+    } // namespace matcher
+} // namespace yaltl
@@ -3,55 +3,104 @@
 #include "utils/command.h"
 
 #include <algorithm>
+#include <cerrno>
+#include <csignal>
 #include <vector>
+
+#include <fcntl.h>
+#include <spawn.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
+extern char **environ;
+
 namespace yaltl
 {
     bool spawn(Command command)
     {
-        // Fork first child to start a new session
-        pid_t pid{fork()};
+        std::vector<char *> argv{command.argv.size() + 1, nullptr};
+        std::transform(std::begin(command.argv), std::end(command.argv), std::begin(argv), [](std::string &str)
+                       { return str.data(); });
+
+        if (!argv[0])
+        {
+            errno = EINVAL;
+            return false;
+        }
+
+        // The child doesn't need the signals we block or handle
+        sigset_t noSignals;
+        sigemptyset(&noSignals);
+        sigset_t allSignals;
+        sigfillset(&allSignals);
+
+#ifdef POSIX_SPAWN_SETSID
+        // posix_spawn shares our memory with the child until it execs instead of copying it like fork,
+        // and reports exec failures, so there's no need to wait on anything
+        posix_spawnattr_t attributes;
+        posix_spawnattr_init(&attributes);
+        posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETSID | POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+        posix_spawnattr_setsigmask(&attributes, &noSignals);
+        posix_spawnattr_setsigdefault(&attributes, &allSignals);
+
+        // command should be the first argument in argv, otherwise certain apps won't run correctly
+        pid_t pid{};
+        const int error{posix_spawnp(&pid, argv[0], nullptr, &attributes, argv.data(), environ)};
+        posix_spawnattr_destroy(&attributes);
+        if (0 != error)
+        {
+            errno = error;
+            return false;
+        }
+
+        return true;
+#else
+        // Without POSIX_SPAWN_SETSID, fork and report exec failures back through a pipe that closes on a successful exec
+        int status[2]{};
+        if (0 != pipe2(status, O_CLOEXEC))
+        {
+            return false;
+        }
+
+        const pid_t pid{fork()};
         if (0 == pid)
         {
-            if (pid < 0)
-            {
-                exit(errno);
-            }
-
-            // Try getting a new session id.
-            pid = setsid();
-            if (pid < 0)
-            {
-                exit(errno);
-            }
-
-            // Fork second child who shall live a very long life
-            pid = fork();
-            if (0 == pid)
-            {
-                std::vector<char *> argv{command.argv.size() + 1, nullptr};
-                std::transform(std::begin(command.argv), std::end(command.argv), std::begin(argv), [](std::string &str)
-                               { return str.data(); });
-
-                // command should be the first argument in argv, otherwise certain apps won't run correctly
-                execvp(argv[0], argv.data());
-            }
-
-            // Exit success or failure for the first child.
-            exit(pid > 0 ? 0 : errno);
+            setsid();
+            sigprocmask(SIG_SETMASK, &noSignals, nullptr);
+            execvp(argv[0], argv.data());
+
+            const int error{errno};
+            write(status[1], &error, sizeof(error));
+            _exit(127);
         }
 
+        close(status[1]);
         if (pid < 0)
         {
+            close(status[0]);
             return false;
         }
 
-        int stat{};
-        waitpid(pid, &stat, 0);
+        int error{};
+        ssize_t count{};
+        do
+        {
+            count = read(status[0], &error, sizeof(error));
+        } while (count < 0 && errno == EINTR);
+
+        close(status[0]);
+
+        // Nothing to read means exec went through
+        if (count != sizeof(error))
+        {
+            return true;
+        }
+
+        // The child already exited, so this doesn't block
+        waitpid(pid, nullptr, 0);
+        errno = error;
 
-        // Oddly, even if we're "successful" here, we don't actually know what happened to the child we care about
-        return WIFEXITED(stat) && 0 == WEXITSTATUS(stat);
+        return false;
+#endif
     }
 } // namespace yaltl
@@ -0,0 +1,282 @@
+#include "utils/subprocess.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <thread>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+//! How much room to make in the buffer for each read
+constexpr size_t SUBPROCESS_READ_SIZE{64 * 1024};
+
+//! How often to check for a stop while the process is quiet
+constexpr int SUBPROCESS_POLL_MS{50};
+
+//! How long a killed process gets to exit after SIGTERM before SIGKILL
+constexpr std::chrono::milliseconds SUBPROCESS_KILL_TIMEOUT{200};
+
+namespace yaltl
+{
+    namespace subprocess
+    {
+        using Clock = std::chrono::steady_clock;
+
+        /**
+         * @brief Converts a wait status to Output::status
+         *
+         */
+        static int exit_status(int status)
+        {
+            return WIFEXITED(status) ? WEXITSTATUS(status) : WIFSIGNALED(status) ? -WTERMSIG(status) : -1;
+        }
+
+        /**
+         * @brief Waits for the process to exit
+         *
+         * @param pid The process to wait on
+         * @param deadline When to give up
+         * @param stop Also gives up when requested
+         * @return std::optional<int> The wait status, nullopt if still running
+         */
+        static std::optional<int> wait_until(pid_t pid, std::optional<Clock::time_point> deadline, const std::stop_token &stop)
+        {
+            int status{};
+            if (!deadline.has_value() && !stop.stop_possible())
+            {
+                return waitpid(pid, &status, 0) == pid ? std::optional<int>{status} : std::nullopt;
+            }
+
+            for (;;)
+            {
+                const pid_t waited{waitpid(pid, &status, WNOHANG)};
+                if (waited == pid)
+                {
+                    return status;
+                }
+
+                if (waited < 0 || stop.stop_requested() || (deadline.has_value() && Clock::now() >= deadline.value()))
+                {
+                    return std::nullopt;
+                }
+
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+
+        /**
+         * @brief Kills the process and everything it started
+         *
+         * @param pid The process, which leads its own process group
+         * @return int The wait status
+         */
+        static int kill_group(pid_t pid)
+        {
+            kill(-pid, SIGTERM);
+            if (std::optional<int> status{wait_until(pid, Clock::now() + SUBPROCESS_KILL_TIMEOUT, {})}; status.has_value())
+            {
+                return status.value();
+            }
+
+            kill(-pid, SIGKILL);
+
+            int status{};
+            waitpid(pid, &status, 0);
+
+            return status;
+        }
+
+        /**
+         * @brief Spawns the process with its stdout going to a pipe
+         *
+         * @param options What to run
+         * @param out [Out] The read end of the pipe
+         * @return pid_t The process, or -1 if it couldn't be started
+         */
+        static pid_t spawn(Options &options, int &out)
+        {
+            if (options.argv.empty())
+            {
+                return -1;
+            }
+
+            int fds[2]{};
+            if (0 != pipe2(fds, O_CLOEXEC))
+            {
+                return -1;
+            }
+
+            posix_spawn_file_actions_t actions;
+            posix_spawn_file_actions_init(&actions);
+            posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+            posix_spawn_file_actions_adddup2(&actions, fds[1], STDOUT_FILENO);
+
+            // Its own process group, so anything it starts gets killed with it
+            posix_spawnattr_t attributes;
+            posix_spawnattr_init(&attributes);
+            posix_spawnattr_setflags(&attributes, POSIX_SPAWN_SETPGROUP);
+            posix_spawnattr_setpgroup(&attributes, 0);
+
+            std::vector<char *> argv;
+            if (options.shell)
+            {
+                argv = {const_cast<char *>("sh"), const_cast<char *>("-c"), options.argv[0].data()};
+            }
+            else
+            {
+                std::transform(std::begin(options.argv), std::end(options.argv), std::back_inserter(argv), [](std::string &arg) {
+                    return arg.data();
+                });
+            }
+
+            argv.push_back(nullptr);
+
+            pid_t pid{};
+            const int error{options.shell ? posix_spawn(&pid, "/bin/sh", &actions, &attributes, argv.data(), environ)
+                                          : posix_spawnp(&pid, argv[0], &actions, &attributes, argv.data(), environ)};
+
+            posix_spawnattr_destroy(&attributes);
+            posix_spawn_file_actions_destroy(&actions);
+            close(fds[1]);
+
+            if (0 != error)
+            {
+                close(fds[0]);
+                return -1;
+            }
+
+            out = fds[0];
+            return pid;
+        }
+
+        Output run(Options options)
+        {
+            Output output;
+            int out{-1};
+            const pid_t pid{spawn(options, out)};
+            if (pid < 0)
+            {
+                return output;
+            }
+
+            fcntl(out, F_SETFL, fcntl(out, F_GETFL) | O_NONBLOCK);
+
+            const std::optional<Clock::time_point> deadline{options.timeout.has_value() ? std::optional<Clock::time_point>{Clock::now() + options.timeout.value()} : std::nullopt};
+
+            // Lines are kept as offsets while reading, growing the buffer moves it
+            std::vector<std::pair<size_t, size_t>> lines;
+            size_t used{};
+            size_t lineStart{};
+            pollfd fd{out, POLLIN, 0};
+            bool open{true};
+            while (open)
+            {
+                if (options.stop.stop_requested() || (deadline.has_value() && Clock::now() >= deadline.value()))
+                {
+                    break;
+                }
+
+                int wait{SUBPROCESS_POLL_MS};
+                if (deadline.has_value())
+                {
+                    wait = static_cast<int>(std::clamp<Clock::rep>(std::chrono::duration_cast<std::chrono::milliseconds>(deadline.value() - Clock::now()).count(), 0, wait));
+                }
+
+                const int ready{poll(&fd, 1, wait)};
+                if (ready < 0 && errno != EINTR)
+                {
+                    break;
+                }
+
+                if (ready <= 0)
+                {
+                    continue;
+                }
+
+                const size_t before{lines.size()};
+                for (;;)
+                {
+                    if (output.buffer.size() - used < SUBPROCESS_READ_SIZE)
+                    {
+                        output.buffer.resize(used + SUBPROCESS_READ_SIZE);
+                    }
+
+                    const ssize_t count{read(out, output.buffer.data() + used, output.buffer.size() - used)};
+                    if (count > 0)
+                    {
+                        used += static_cast<size_t>(count);
+                    }
+                    else if (count < 0 && errno == EINTR)
+                    {
+                        continue;
+                    }
+                    else
+                    {
+                        open = count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+                        break;
+                    }
+                }
+
+                const char *data{output.buffer.data()};
+                for (const char *newline{static_cast<const char *>(memchr(data + lineStart, '\n', used - lineStart))}; newline; newline = static_cast<const char *>(memchr(data + lineStart, '\n', used - lineStart)))
+                {
+                    const size_t end{static_cast<size_t>(newline - data)};
+                    if (end > lineStart)
+                    {
+                        lines.emplace_back(lineStart, end - lineStart);
+                    }
+
+                    lineStart = end + 1;
+                }
+
+                // Whatever is left once the output closes is the last line
+                if (!open && used > lineStart)
+                {
+                    lines.emplace_back(lineStart, used - lineStart);
+                    lineStart = used;
+                }
+
+                if (options.on_lines && lines.size() > before)
+                {
+                    std::vector<std::string_view> views;
+                    views.reserve(lines.size() - before);
+                    std::transform(std::begin(lines) + before, std::end(lines), std::back_inserter(views), [data](const std::pair<size_t, size_t> &line) {
+                        return std::string_view{data + line.first, line.second};
+                    });
+
+                    options.on_lines(views);
+                }
+            }
+
+            close(out);
+
+            std::optional<int> status;
+            if (!open)
+            {
+                status = wait_until(pid, deadline, options.stop);
+            }
+
+            if (!status.has_value())
+            {
+                status = kill_group(pid);
+                output.killed = true;
+            }
+
+            output.status = exit_status(status.value());
+            output.buffer.resize(used);
+            output.lines.reserve(lines.size());
+            std::transform(std::begin(lines), std::end(lines), std::back_inserter(output.lines), [&output](const std::pair<size_t, size_t> &line) {
+                return std::string_view{output.buffer.data() + line.first, line.second};
+            });
+
+            return output;
+        }
+    } // namespace subprocess
+} // namespace yaltl
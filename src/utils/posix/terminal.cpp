@@ -0,0 +1,85 @@
+#include "utils/terminal.h"
+
+#include <atomic>
+#include <mutex>
+#include <optional>
+
+#include <signal.h>
+
+namespace yaltl
+{
+    namespace terminal
+    {
+        namespace
+        {
+            //! Starts out set so the first size is read from the terminal
+            std::atomic<bool> g_resized{true};
+
+            std::optional<ftxui::Terminal::Dimensions> g_pinned;
+
+            struct sigaction g_previous{};
+
+            void on_resize(int signal, siginfo_t *info, void *context)
+            {
+                g_resized = true;
+
+                // Whoever was listening before still gets to hear about it
+                if (g_previous.sa_flags & SA_SIGINFO)
+                {
+                    g_previous.sa_sigaction(signal, info, context);
+                }
+                else if (g_previous.sa_handler != SIG_DFL && g_previous.sa_handler != SIG_IGN)
+                {
+                    g_previous.sa_handler(signal);
+                }
+            }
+
+            void watch()
+            {
+                static std::once_flag installed;
+                std::call_once(installed, [] {
+                    struct sigaction action{};
+                    action.sa_sigaction = on_resize;
+                    action.sa_flags = SA_SIGINFO | SA_RESTART;
+                    sigemptyset(&action.sa_mask);
+                    sigaction(SIGWINCH, &action, &g_previous);
+                });
+            }
+        } // namespace
+
+        ftxui::Terminal::Dimensions size()
+        {
+            if (g_pinned.has_value())
+            {
+                return g_pinned.value();
+            }
+
+            watch();
+
+            static ftxui::Terminal::Dimensions cached{};
+            if (g_resized.exchange(false))
+            {
+                cached = ftxui::Terminal::Size();
+            }
+
+            return cached;
+        }
+
+        bool resized()
+        {
+            if (g_pinned.has_value())
+            {
+                return false;
+            }
+
+            watch();
+
+            return g_resized;
+        }
+
+        void pin(ftxui::Terminal::Dimensions size)
+        {
+            g_pinned = size;
+        }
+    } // namespace terminal
+} // namespace yaltl
@@ -0,0 +1,109 @@
+#include "utils/previewer.h"
+#include "utils/trace.h"
+
+#include <utility>
+
+//! How long the selection has to stay put before a preview gets built
+constexpr std::chrono::milliseconds PREVIEW_DEBOUNCE{80};
+
+//! How many previews to keep around for entries that were selected before
+constexpr size_t PREVIEW_CACHE_SIZE{64};
+
+namespace yaltl
+{
+    Previewer::Previewer(std::function<void()> refresh) : m_refresh(std::move(refresh)), m_cache{PREVIEW_CACHE_SIZE}
+    {
+        m_worker = std::jthread{[this](std::stop_token stop) { Run(stop); }};
+    }
+
+    std::optional<ftxui::Element> Previewer::Get(Mode &mode, const std::shared_ptr<Entry> &entry)
+    {
+        std::scoped_lock lock{m_lock};
+        if (const ftxui::Element *cached{m_cache.Find(entry)})
+        {
+            return *cached;
+        }
+
+        // Built without a preview, which isn't kept past this selection
+        if (m_requested == entry && m_missing == entry)
+        {
+            return ftxui::Element{};
+        }
+
+        if (m_requested != entry)
+        {
+            // The selection moved on, whatever is being built is no longer wanted
+            m_building.Cancel();
+            m_missing.reset();
+            m_requested = entry;
+            m_pending = Request{&mode, entry, Clock::now() + PREVIEW_DEBOUNCE};
+            m_wake.notify_one();
+        }
+
+        return std::nullopt;
+    }
+
+    void Previewer::Run(std::stop_token stop)
+    {
+        std::stop_callback cancelOnStop{stop, [this] {
+                                            std::scoped_lock lock{m_lock};
+                                            m_building.Cancel();
+                                        }};
+
+        std::unique_lock lock{m_lock};
+        while (!stop.stop_requested())
+        {
+            if (!m_pending.has_value())
+            {
+                m_wake.wait(lock, stop, [this] { return m_pending.has_value(); });
+                continue;
+            }
+
+            // Newer requests push the deadline back, so check again after waking up
+            if (const Clock::time_point due{m_pending->due}; Clock::now() < due)
+            {
+                m_wake.wait_until(lock, stop, due, [this, due] { return !m_pending.has_value() || m_pending->due != due; });
+                continue;
+            }
+
+            executor::Job superseded{std::exchange(m_building, executor::submit(executor::Lane::Preview, [this, request{std::move(m_pending.value())}](std::stop_token cancel) {
+                                                                Build(request, cancel);
+                                                            }))};
+            m_pending.reset();
+
+            // It was cancelled when it was superseded, waiting for it to notice needs the lock to be free
+            lock.unlock();
+            superseded = executor::Job{};
+            lock.lock();
+        }
+    }
+
+    void Previewer::Build(const Request &request, std::stop_token cancel)
+    {
+        ftxui::Element preview;
+        {
+            trace::Span span{"Previewer::Preview"};
+            preview = request.mode->Preview(*request.entry, cancel);
+        }
+
+        {
+            std::scoped_lock lock{m_lock};
+            if (cancel.stop_requested())
+            {
+                return;
+            }
+
+            // No preview may only mean not yet, i.e: a mount that timed out, so it's asked for again next time
+            if (preview)
+            {
+                m_cache.Put(request.entry, std::move(preview));
+            }
+            else
+            {
+                m_missing = request.entry;
+            }
+        }
+
+        m_refresh();
+    }
+} // namespace yaltl
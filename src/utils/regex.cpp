@@ -6,6 +6,7 @@
 #include <numeric>
 #include <sstream>
 #include <string>
+#include <cwctype>
 
 constexpr auto REGEX_DELIM = L".*";
 constexpr auto SPECIAL_CHARS = L".()[\\+$^*|?";
@@ -30,6 +31,66 @@ namespace yaltl
 
             return pattern;
         }
+
+        std::vector<size_t> match_positions(std::wstring_view outer, std::wstring_view search)
+        {
+            auto fold{[](wchar_t ch) { return static_cast<wchar_t>(std::towlower(ch)); }};
+
+            std::wstring folded;
+            folded.reserve(search.size());
+            for (wchar_t ch : search)
+            {
+                if (!std::iswspace(ch))
+                {
+                    folded.push_back(fold(ch));
+                }
+            }
+
+            std::vector<size_t> best;
+            if (folded.empty())
+            {
+                return best;
+            }
+
+            // Matching greedily from each start finds the earliest end for it, so the shortest of those is the tightest match
+            std::vector<size_t> positions;
+            positions.reserve(folded.size());
+            for (size_t start{}; start < outer.size(); ++start)
+            {
+                if (fold(outer[start]) != folded.front())
+                {
+                    continue;
+                }
+
+                positions.clear();
+                for (size_t pos{start}; pos < outer.size() && positions.size() < folded.size(); ++pos)
+                {
+                    if (fold(outer[pos]) == folded[positions.size()])
+                    {
+                        positions.push_back(pos);
+                    }
+                }
+
+                // Nothing further along matches if this didn't
+                if (positions.size() < folded.size())
+                {
+                    break;
+                }
+
+                if (best.empty() || positions.back() - positions.front() < best.back() - best.front())
+                {
+                    best = positions;
+                }
+
+                // Can't get any tighter than the search as is
+                if (best.back() - best.front() + 1 == folded.size())
+                {
+                    break;
+                }
+            }
+
+            return best;
+        }
     } // namespace regex
 
 } // namespace yaltl
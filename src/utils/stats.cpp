@@ -0,0 +1,208 @@
+#include "utils/stats.h"
+#include "utils/file.h"
+#include "utils/histogram.h"
+
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <cwchar>
+#include <iostream>
+#include <streambuf>
+#include <utility>
+
+namespace yaltl
+{
+    namespace stats
+    {
+        namespace details
+        {
+            thread_local bool t_enabled{};
+        } // namespace details
+
+        namespace
+        {
+            constexpr std::array<const char *, static_cast<size_t>(Stage::Count)> STAGE_NAMES{"compile", "scan", "rank", "render", "flush"};
+
+            /**
+             * @brief Passes everything on to another buffer, adding up the time spent writing
+             * 
+             */
+            class TimedBuffer : public std::streambuf
+            {
+            public:
+                explicit TimedBuffer(std::streambuf *inner) : m_inner(inner)
+                {
+                }
+
+                std::streambuf *Inner() const
+                {
+                    return m_inner;
+                }
+
+                //! Time spent writing since the last call
+                Clock::duration Take()
+                {
+                    return std::exchange(m_spent, Clock::duration{});
+                }
+
+            protected:
+                int_type overflow(int_type ch) override
+                {
+                    const Clock::time_point begin{Clock::now()};
+                    const int_type result{traits_type::eq_int_type(ch, traits_type::eof()) ? traits_type::not_eof(ch) : m_inner->sputc(traits_type::to_char_type(ch))};
+                    m_spent += Clock::now() - begin;
+
+                    return result;
+                }
+
+                std::streamsize xsputn(const char_type *text, std::streamsize count) override
+                {
+                    const Clock::time_point begin{Clock::now()};
+                    const std::streamsize result{m_inner->sputn(text, count)};
+                    m_spent += Clock::now() - begin;
+
+                    return result;
+                }
+
+                int sync() override
+                {
+                    const Clock::time_point begin{Clock::now()};
+                    const int result{m_inner->pubsync()};
+                    m_spent += Clock::now() - begin;
+
+                    return result;
+                }
+
+            private:
+                std::streambuf *m_inner;
+                Clock::duration m_spent{};
+            };
+
+            struct State
+            {
+                std::array<Histogram, static_cast<size_t>(Stage::Count)> histograms;
+                std::array<Clock::duration, static_cast<size_t>(Stage::Count)> last{};
+                size_t candidates{};
+                size_t matches{};
+                std::string file;
+                std::optional<TimedBuffer> output;
+            };
+
+            State &state()
+            {
+                static State instance;
+
+                return instance;
+            }
+
+            std::wstring milliseconds(uint64_t nanoseconds)
+            {
+                wchar_t text[16]{};
+                swprintf(text, std::size(text), L"%.2f", nanoseconds / 1e6);
+
+                return text;
+            }
+        } // namespace
+
+        bool start(const std::string &file)
+        {
+            // Better to find out it can't be written now than after the session
+            if (!file.empty())
+            {
+                if (unique_file probe{fopen(file.c_str(), "w")}; !probe)
+                {
+                    return false;
+                }
+            }
+
+            State &stats{state()};
+            stats.file = file;
+            stats.output.emplace(std::cout.rdbuf());
+            std::cout.rdbuf(&stats.output.value());
+            details::t_enabled = true;
+
+            return true;
+        }
+
+        void stop()
+        {
+            if (!std::exchange(details::t_enabled, false))
+            {
+                return;
+            }
+
+            State &stats{state()};
+            std::cout.rdbuf(stats.output->Inner());
+            stats.output.reset();
+
+            std::string json{"{\"unit\":\"ns\",\"stages\":{"};
+            for (size_t stage{}; stage < stats.histograms.size(); ++stage)
+            {
+                json += (stage == 0 ? "\"" : ",\"") + std::string{STAGE_NAMES[stage]} + "\":" + stats.histograms[stage].Json();
+            }
+
+            json += "}}\n";
+
+            if (stats.file.empty())
+            {
+                fputs(json.c_str(), stderr);
+            }
+            else if (unique_file out{fopen(stats.file.c_str(), "w")}; out)
+            {
+                fputs(json.c_str(), out.get());
+            }
+        }
+
+        void record(Stage stage, Clock::duration duration)
+        {
+            if (!enabled())
+            {
+                return;
+            }
+
+            State &stats{state()};
+            stats.histograms[static_cast<size_t>(stage)].Record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()));
+            stats.last[static_cast<size_t>(stage)] = duration;
+        }
+
+        void matched(size_t candidates, size_t matches)
+        {
+            if (!enabled())
+            {
+                return;
+            }
+
+            State &stats{state()};
+            stats.candidates = candidates;
+            stats.matches = matches;
+        }
+
+        void frame()
+        {
+            if (!enabled())
+            {
+                return;
+            }
+
+            // Nothing was written between the frames, i.e: the first one
+            if (const Clock::duration spent{state().output->Take()}; spent > Clock::duration{})
+            {
+                record(Stage::Flush, spent);
+            }
+        }
+
+        std::wstring status()
+        {
+            State &stats{state()};
+            std::wstring line;
+            for (size_t stage{}; stage < stats.histograms.size(); ++stage)
+            {
+                const uint64_t last{static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(stats.last[stage]).count())};
+                line += std::wstring{STAGE_NAMES[stage], STAGE_NAMES[stage] + strlen(STAGE_NAMES[stage])} + L' ' +
+                        milliseconds(last) + L'/' + milliseconds(stats.histograms[stage].Percentile(99)) + L"  ";
+            }
+
+            return line + L"ms (last/p99)  " + std::to_wstring(stats.matches) + L'/' + std::to_wstring(stats.candidates) + L" matched";
+        }
+    } // namespace stats
+} // namespace yaltl
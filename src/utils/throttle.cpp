@@ -0,0 +1,48 @@
+#include "utils/throttle.h"
+
+namespace yaltl
+{
+    Throttle::Throttle(std::function<void()> call, Clock::duration interval) : m_call(std::move(call)), m_interval(interval)
+    {
+        m_worker = std::jthread{[this](std::stop_token stop) { Run(stop); }};
+    }
+
+    void Throttle::Request()
+    {
+        {
+            std::scoped_lock lock{m_lock};
+            if (m_requested)
+            {
+                return;
+            }
+
+            m_requested = true;
+        }
+
+        m_wake.notify_one();
+    }
+
+    void Throttle::Run(std::stop_token stop)
+    {
+        Clock::time_point last{};
+        std::unique_lock lock{m_lock};
+        while (m_wake.wait(lock, stop, [this] { return m_requested; }))
+        {
+            // Requests that come in while waiting out the interval ride along with this call
+            if (const Clock::time_point due{last + m_interval}; Clock::now() < due)
+            {
+                m_wake.wait_until(lock, stop, due, [] { return false; });
+                if (stop.stop_requested())
+                {
+                    break;
+                }
+            }
+
+            m_requested = false;
+            lock.unlock();
+            m_call();
+            last = Clock::now();
+            lock.lock();
+        }
+    }
+} // namespace yaltl
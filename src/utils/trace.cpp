@@ -0,0 +1,137 @@
+#include "utils/trace.h"
+#include "utils/file.h"
+#include "utils/json.h"
+
+#include <mutex>
+#include <optional>
+#include <vector>
+
+//! Past this many events the rest are dropped, a long session shouldn't grow without bound
+constexpr size_t MAX_EVENTS = 1 << 20;
+
+namespace yaltl
+{
+    namespace trace
+    {
+        namespace details
+        {
+            std::atomic<bool> g_enabled{};
+        } // namespace details
+
+        namespace
+        {
+            struct Event
+            {
+                std::string name;
+                Clock::time_point begin;
+
+                //! Unset for marks
+                std::optional<Clock::duration> duration;
+                uint32_t thread{};
+            };
+
+            std::mutex g_lock;
+            std::vector<Event> g_events;
+            std::string g_file;
+            Clock::time_point g_origin;
+
+            //! Small stable ids read better in the viewer than native thread ids
+            uint32_t thread_id()
+            {
+                static std::atomic<uint32_t> next{1};
+                thread_local const uint32_t id{next++};
+
+                return id;
+            }
+
+            void record(Event &&event)
+            {
+                std::scoped_lock lock{g_lock};
+                if (g_events.size() < MAX_EVENTS)
+                {
+                    g_events.push_back(std::move(event));
+                }
+            }
+
+            int64_t micros(Clock::duration duration)
+            {
+                return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+            }
+        } // namespace
+
+        bool start(const std::string &file, Clock::time_point origin)
+        {
+            // Better to find out it can't be written now than after the session
+            if (unique_file probe{fopen(file.c_str(), "w")}; !probe)
+            {
+                return false;
+            }
+
+            std::scoped_lock lock{g_lock};
+            g_file = file;
+
+            // The thread that starts tracing is shown first
+            thread_id();
+            g_origin = origin;
+            g_events.reserve(1024);
+            details::g_enabled = true;
+
+            return true;
+        }
+
+        void stop()
+        {
+            if (!details::g_enabled.exchange(false))
+            {
+                return;
+            }
+
+            std::scoped_lock lock{g_lock};
+            unique_file out{fopen(g_file.c_str(), "w")};
+            if (!out)
+            {
+                g_events = {};
+                return;
+            }
+
+            fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", out.get());
+            for (size_t x{}; x < g_events.size(); ++x)
+            {
+                const Event &event{g_events[x]};
+                fprintf(out.get(), "%s\n{\"name\":%s,\"cat\":\"yaltl\",\"pid\":1,\"tid\":%u,\"ts\":%lld",
+                        x == 0 ? "" : ",",
+                        json::quote(event.name).c_str(),
+                        event.thread,
+                        static_cast<long long>(micros(event.begin - g_origin)));
+
+                if (event.duration.has_value())
+                {
+                    fprintf(out.get(), ",\"ph\":\"X\",\"dur\":%lld}", static_cast<long long>(micros(event.duration.value())));
+                }
+                else
+                {
+                    fputs(",\"ph\":\"i\",\"s\":\"t\"}", out.get());
+                }
+            }
+
+            fputs("\n]}\n", out.get());
+            g_events = {};
+        }
+
+        void complete(std::string name, Clock::time_point begin, Clock::time_point end)
+        {
+            if (enabled())
+            {
+                record(Event{std::move(name), begin, end - begin, thread_id()});
+            }
+        }
+
+        void mark(std::string name)
+        {
+            if (enabled())
+            {
+                record(Event{std::move(name), Clock::now(), std::nullopt, thread_id()});
+            }
+        }
+    } // namespace trace
+} // namespace yaltl
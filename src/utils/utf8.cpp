@@ -0,0 +1,74 @@
+#include "utils/utf8.h"
+
+#include <cstdint>
+
+//! What bytes that aren't valid UTF-8 become
+constexpr uint32_t REPLACEMENT{0xfffd};
+
+namespace yaltl
+{
+    namespace utf8
+    {
+        namespace
+        {
+            //! Appends a character, past U+FFFF as a surrogate pair the same as std::codecvt_utf8_utf16
+            void push(std::wstring &out, uint32_t code)
+            {
+                if (code >= 0x10000)
+                {
+                    code -= 0x10000;
+                    out.push_back(static_cast<wchar_t>(0xd800 + (code >> 10)));
+                    out.push_back(static_cast<wchar_t>(0xdc00 + (code & 0x3ff)));
+                    return;
+                }
+
+                out.push_back(static_cast<wchar_t>(code));
+            }
+        } // namespace
+
+        void widen(std::string_view in, std::wstring &out)
+        {
+            out.clear();
+            out.reserve(in.size());
+            for (size_t pos{}; pos < in.size();)
+            {
+                const uint8_t lead{static_cast<uint8_t>(in[pos])};
+                if (lead < 0x80)
+                {
+                    out.push_back(static_cast<wchar_t>(lead));
+                    ++pos;
+                    continue;
+                }
+
+                // Continuation bytes, and leads that could only start an overlong form or something past U+10FFFF
+                if (lead < 0xc2 || lead > 0xf4)
+                {
+                    push(out, REPLACEMENT);
+                    ++pos;
+                    continue;
+                }
+
+                const size_t length{lead >= 0xf0 ? 4u : lead >= 0xe0 ? 3u : 2u};
+                const uint32_t least{length == 4 ? 0x10000u : length == 3 ? 0x800u : 0x80u};
+                uint32_t code{lead & (0xffu >> (length + 1))};
+                size_t next{pos + 1};
+                for (; next < pos + length && next < in.size() && (static_cast<uint8_t>(in[next]) & 0xc0) == 0x80; ++next)
+                {
+                    code = (code << 6) | (static_cast<uint8_t>(in[next]) & 0x3f);
+                }
+
+                const bool valid{next == pos + length && code >= least && code <= 0x10ffff && (code < 0xd800 || code > 0xdfff)};
+                push(out, valid ? code : REPLACEMENT);
+                pos = next;
+            }
+        }
+
+        std::wstring widen(std::string_view in)
+        {
+            std::wstring out;
+            widen(in, out);
+
+            return out;
+        }
+    } // namespace utf8
+} // namespace yaltl
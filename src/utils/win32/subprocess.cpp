@@ -0,0 +1,95 @@
+#include "utils/subprocess.h"
+
+#include <stdio.h>
+
+#include <mtl/memory.hpp>
+
+namespace yaltl
+{
+    namespace subprocess
+    {
+        using unique_pfile = mtl::unique_ptr<decltype(::_pclose), &::_pclose>;
+
+        Output run(Options options)
+        {
+            Output output;
+            if (options.argv.empty())
+            {
+                return output;
+            }
+
+            // _popen always goes through the shell, so quote the arguments when running argv
+            std::string command{options.argv[0]};
+            if (!options.shell)
+            {
+                command = "\"" + command + "\"";
+                for (size_t x{1}; x < options.argv.size(); ++x)
+                {
+                    command += " \"" + options.argv[x] + "\"";
+                }
+            }
+
+            // The pipe can't be polled, so stops are only noticed between reads and timeouts aren't supported
+            FILE *file{::_popen(command.c_str(), "r")};
+            if (!file)
+            {
+                return output;
+            }
+
+            std::vector<std::pair<size_t, size_t>> lines;
+            size_t used{};
+            size_t lineStart{};
+            char chunk[4096];
+            for (size_t count{fread(chunk, 1, sizeof(chunk), file)}; count > 0 && !options.stop.stop_requested(); count = fread(chunk, 1, sizeof(chunk), file))
+            {
+                output.buffer.insert(std::end(output.buffer), chunk, chunk + count);
+                used += count;
+
+                const size_t before{lines.size()};
+                for (size_t x{used - count}; x < used; ++x)
+                {
+                    if (output.buffer[x] == '\n')
+                    {
+                        const size_t end{x > lineStart && output.buffer[x - 1] == '\r' ? x - 1 : x};
+                        if (end > lineStart)
+                        {
+                            lines.emplace_back(lineStart, end - lineStart);
+                        }
+
+                        lineStart = x + 1;
+                    }
+                }
+
+                if (options.on_lines && lines.size() > before)
+                {
+                    std::vector<std::string_view> views;
+                    for (size_t x{before}; x < lines.size(); ++x)
+                    {
+                        views.emplace_back(output.buffer.data() + lines[x].first, lines[x].second);
+                    }
+
+                    options.on_lines(views);
+                }
+            }
+
+            output.killed = options.stop.stop_requested();
+            if (!output.killed && used > lineStart)
+            {
+                lines.emplace_back(lineStart, used - lineStart);
+                if (options.on_lines)
+                {
+                    options.on_lines({std::string_view{output.buffer.data() + lineStart, used - lineStart}});
+                }
+            }
+
+            // Closing waits on the process, even if it was stopped
+            output.status = ::_pclose(file);
+            for (const auto &[start, length] : lines)
+            {
+                output.lines.emplace_back(output.buffer.data() + start, length);
+            }
+
+            return output;
+        }
+    } // namespace subprocess
+} // namespace yaltl
@@ -0,0 +1,46 @@
+#include "utils/terminal.h"
+
+#include <optional>
+
+namespace yaltl
+{
+    namespace terminal
+    {
+        namespace
+        {
+            ftxui::Terminal::Dimensions g_size{};
+
+            std::optional<ftxui::Terminal::Dimensions> g_pinned;
+        } // namespace
+
+        // There's no SIGWINCH, so the console is asked every time
+        ftxui::Terminal::Dimensions size()
+        {
+            if (g_pinned.has_value())
+            {
+                return g_pinned.value();
+            }
+
+            g_size = ftxui::Terminal::Size();
+
+            return g_size;
+        }
+
+        bool resized()
+        {
+            if (g_pinned.has_value())
+            {
+                return false;
+            }
+
+            const ftxui::Terminal::Dimensions current{ftxui::Terminal::Size()};
+
+            return current.dimx != g_size.dimx || current.dimy != g_size.dimy;
+        }
+
+        void pin(ftxui::Terminal::Dimensions size)
+        {
+            g_pinned = size;
+        }
+    } // namespace terminal
+} // namespace yaltl
@@ -0,0 +1,347 @@
+#include "utils/xml.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+namespace yaltl
+{
+    namespace xml
+    {
+        namespace
+        {
+            /**
+             * @brief Appends the code point as UTF-8
+             * 
+             * @param out The string to append to
+             * @param code The code point
+             */
+            void append_utf8(std::string &out, unsigned long code)
+            {
+                if (code < 0x80)
+                {
+                    out += static_cast<char>(code);
+                }
+                else if (code < 0x800)
+                {
+                    out += static_cast<char>(0xC0 | (code >> 6));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                }
+                else if (code < 0x10000)
+                {
+                    out += static_cast<char>(0xE0 | (code >> 12));
+                    out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                }
+                else
+                {
+                    out += static_cast<char>(0xF0 | (code >> 18));
+                    out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+                    out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                }
+            }
+
+            /**
+             * @brief Replaces entity and character references
+             * 
+             * @param raw The escaped text
+             * @return std::string The unescaped text
+             */
+            std::string unescape(std::string_view raw)
+            {
+                if (raw.find('&') == std::string_view::npos)
+                {
+                    return std::string{raw};
+                }
+
+                std::string result;
+                result.reserve(raw.size());
+                for (size_t x{}; x < raw.size(); ++x)
+                {
+                    const size_t semicolon{raw[x] == '&' ? raw.find(';', x) : std::string_view::npos};
+                    if (semicolon == std::string_view::npos)
+                    {
+                        result += raw[x];
+                        continue;
+                    }
+
+                    const std::string_view entity{raw.substr(x + 1, semicolon - x - 1)};
+                    if (entity == "amp")
+                    {
+                        result += '&';
+                    }
+                    else if (entity == "lt")
+                    {
+                        result += '<';
+                    }
+                    else if (entity == "gt")
+                    {
+                        result += '>';
+                    }
+                    else if (entity == "quot")
+                    {
+                        result += '"';
+                    }
+                    else if (entity == "apos")
+                    {
+                        result += '\'';
+                    }
+                    else if (entity.size() > 1 && entity[0] == '#')
+                    {
+                        const bool hex{entity[1] == 'x' || entity[1] == 'X'};
+                        append_utf8(result, std::strtoul(std::string{entity.substr(hex ? 2 : 1)}.c_str(), nullptr, hex ? 16 : 10));
+                    }
+                    else
+                    {
+                        // Unknown entity, leave it alone
+                        result += raw.substr(x, semicolon - x + 1);
+                    }
+
+                    x = semicolon;
+                }
+
+                return result;
+            }
+
+            /**
+             * @brief Reads the stream until the terminator, consuming the terminator
+             * 
+             * @param input The stream
+             * @param terminator What to read up to
+             * @param out [Out] What was read before the terminator
+             * @return true - Terminator was found
+             */
+            bool read_until(std::streambuf &input, std::string_view terminator, std::string &out)
+            {
+                out.clear();
+                for (int ch{input.sbumpc()}; ch != std::char_traits<char>::eof(); ch = input.sbumpc())
+                {
+                    out += static_cast<char>(ch);
+                    if (out.size() >= terminator.size() && std::string_view{out}.substr(out.size() - terminator.size()) == terminator)
+                    {
+                        out.resize(out.size() - terminator.size());
+                        return true;
+                    }
+                }
+
+                return false;
+            }
+
+            /**
+             * @brief Reads the rest of a tag up to the closing >, which may appear in quoted attribute values
+             * 
+             * @param input The stream, just after the <
+             * @param out [Out] The tag contents without angle brackets
+             * @return true - The tag was closed
+             */
+            bool read_tag(std::streambuf &input, std::string &out)
+            {
+                out.clear();
+                char quote{};
+                for (int ch{input.sbumpc()}; ch != std::char_traits<char>::eof(); ch = input.sbumpc())
+                {
+                    if (quote)
+                    {
+                        quote = ch == quote ? 0 : quote;
+                    }
+                    else if (ch == '"' || ch == '\'')
+                    {
+                        quote = static_cast<char>(ch);
+                    }
+                    else if (ch == '>')
+                    {
+                        return true;
+                    }
+
+                    out += static_cast<char>(ch);
+                }
+
+                return false;
+            }
+
+            /**
+             * @brief Parses the inside of a tag, i.e: name key="value" key2='value'
+             * 
+             * @param tag The tag without the angle brackets or trailing slash
+             * @param name [Out] The element name
+             * @param attributes [Out] The unescaped attributes
+             * @return true - The tag was well formed
+             */
+            bool parse_tag(std::string_view tag, std::string_view &name, Attributes &attributes)
+            {
+                auto isSpace{[](char ch) { return std::isspace(static_cast<unsigned char>(ch)); }};
+                size_t pos{static_cast<size_t>(std::find_if(std::begin(tag), std::end(tag), isSpace) - std::begin(tag))};
+                name = tag.substr(0, pos);
+                attributes.clear();
+                while (pos < tag.size())
+                {
+                    pos = tag.find_first_not_of(" \t\r\n", pos);
+                    if (pos == std::string_view::npos)
+                    {
+                        break;
+                    }
+
+                    const size_t equals{tag.find('=', pos)};
+                    if (equals == std::string_view::npos)
+                    {
+                        return false;
+                    }
+
+                    std::string_view key{tag.substr(pos, equals - pos)};
+                    key = key.substr(0, key.find_last_not_of(" \t\r\n") + 1);
+
+                    const size_t open{tag.find_first_not_of(" \t\r\n", equals + 1)};
+                    if (open == std::string_view::npos || (tag[open] != '"' && tag[open] != '\''))
+                    {
+                        return false;
+                    }
+
+                    const size_t close{tag.find(tag[open], open + 1)};
+                    if (close == std::string_view::npos)
+                    {
+                        return false;
+                    }
+
+                    attributes.emplace_back(std::string{key}, unescape(tag.substr(open + 1, close - open - 1)));
+                    pos = close + 1;
+                }
+
+                return !name.empty();
+            }
+        } // namespace
+
+        std::optional<std::string_view> attribute(const Attributes &attributes, std::string_view name)
+        {
+            auto itr{std::find_if(std::begin(attributes), std::end(attributes), [name](const auto &attribute) {
+                return attribute.first == name;
+            })};
+
+            if (itr == std::end(attributes))
+            {
+                return std::nullopt;
+            }
+
+            return itr->second;
+        }
+
+        bool parse(std::istream &input, const Handler &handler)
+        {
+            std::streambuf *buffer{input.rdbuf()};
+            if (!buffer)
+            {
+                return false;
+            }
+
+            std::string text;
+            std::string tag;
+            Attributes attributes;
+            for (int ch{buffer->sbumpc()}; ch != std::char_traits<char>::eof(); ch = buffer->sbumpc())
+            {
+                if (ch != '<')
+                {
+                    text += static_cast<char>(ch);
+                    continue;
+                }
+
+                if (!text.empty())
+                {
+                    if (handler.on_text && text.find_first_not_of(" \t\r\n") != std::string::npos)
+                    {
+                        handler.on_text(unescape(text));
+                    }
+
+                    text.clear();
+                }
+
+                const int next{buffer->sgetc()};
+                if (next == '?')
+                {
+                    // Processing instruction, i.e: <?xml version="1.0"?>
+                    if (!read_until(*buffer, "?>", tag))
+                    {
+                        return false;
+                    }
+
+                    continue;
+                }
+
+                if (next == '!')
+                {
+                    if (!read_until(*buffer, ">", tag))
+                    {
+                        return false;
+                    }
+
+                    if (tag.starts_with("!--") && !tag.ends_with("--"))
+                    {
+                        // Comment had a > in it, keep going to the real end
+                        std::string rest;
+                        if (!read_until(*buffer, "-->", rest))
+                        {
+                            return false;
+                        }
+                    }
+                    else if (tag.starts_with("![CDATA[") && handler.on_text)
+                    {
+                        std::string data{tag.substr(8)};
+                        if (!data.ends_with("]]"))
+                        {
+                            std::string rest;
+                            if (!read_until(*buffer, "]]>", rest))
+                            {
+                                return false;
+                            }
+
+                            data += ">" + rest;
+                        }
+                        else
+                        {
+                            data.resize(data.size() - 2);
+                        }
+
+                        handler.on_text(data);
+                    }
+
+                    continue;
+                }
+
+                if (!read_tag(*buffer, tag))
+                {
+                    return false;
+                }
+
+                if (tag.starts_with('/'))
+                {
+                    if (handler.on_end)
+                    {
+                        std::string_view name{tag};
+                        name.remove_prefix(1);
+                        handler.on_end(name.substr(0, name.find_last_not_of(" \t\r\n") + 1));
+                    }
+
+                    continue;
+                }
+
+                const bool selfClosing{tag.ends_with('/')};
+                std::string_view name;
+                if (!parse_tag(std::string_view{tag}.substr(0, tag.size() - (selfClosing ? 1 : 0)), name, attributes))
+                {
+                    return false;
+                }
+
+                if (handler.on_start)
+                {
+                    handler.on_start(name, attributes);
+                }
+
+                if (selfClosing && handler.on_end)
+                {
+                    handler.on_end(name);
+                }
+            }
+
+            return true;
+        }
+    } // namespace xml
+} // namespace yaltl
@@ -1,45 +1,144 @@
 #include "yaltl.h"
-#include "mtl/details/istring.hpp"
+#include "utils/executor.h"
+#include "utils/frontcoded.h"
+#include "utils/matcher.h"
+#include "utils/stats.h"
+#include "utils/terminal.h"
+#include "utils/trace.h"
 
 #include <algorithm>
-#include <ftxui/screen/terminal.hpp>
+#include <numeric>
+#include <utility>
+
+//! Background updates and typing are picked up at most this often, about 60 frames a second
+constexpr std::chrono::milliseconds FRAME_INTERVAL{16};
+
+//! Most results made entries from a compact store per search, far more than anyone scrolls through
+constexpr size_t STORE_RESULTS{10'000};
 
 namespace yaltl
 {
-    Yaltl::Yaltl(Modes &&modes) : m_container{ftxui::Container::Vertical()}, m_search{}, m_mode{}, m_modes{std::move(modes)}
+    namespace
     {
+        /**
+         * @brief Merges ranked results into others, both ordered as exact matches first then by fuzz
+         * 
+         * @param into The results to merge into
+         * @param intoExact [In/Out] How many of into are exact matches
+         * @param from The results to merge
+         * @param fromExact How many of from are exact matches
+         */
+        void merge(std::vector<FuzzyResult> &into, size_t &intoExact, std::vector<FuzzyResult> &&from, size_t fromExact)
+        {
+            if (into.empty())
+            {
+                into = std::move(from);
+                intoExact = fromExact;
+                return;
+            }
+
+            // Merge each part on its own so exact matches stay first
+            std::vector<FuzzyResult> merged;
+            merged.reserve(into.size() + from.size());
+            auto intoInexact{std::begin(into) + intoExact};
+            auto fromInexact{std::begin(from) + fromExact};
+            std::merge(std::begin(into), intoInexact, std::begin(from), fromInexact, std::back_inserter(merged));
+            std::merge(intoInexact, std::end(into), fromInexact, std::end(from), std::back_inserter(merged));
+
+            into = std::move(merged);
+            intoExact += fromExact;
+        }
+
+        //! Counts the results of a mode, compact or not
+        size_t count(Mode &mode)
+        {
+            const FrontCoded *store{mode.Store()};
+            return store ? store->Size() : mode.Results().size();
+        }
+
+        //! Sums up how many entries the sources have had searched
+        template <typename Sources>
+        size_t searched(const Sources &sources)
+        {
+            return std::accumulate(std::begin(sources), std::end(sources), size_t{}, [](size_t total, const auto &source) { return total + source.searched; });
+        }
+    } // namespace
+
+    Yaltl::Yaltl(Modes &&modes, std::function<void()> refresh) : m_container{ftxui::Container::Vertical()}, m_search{}, m_mode{}, m_updates{std::move(refresh), FRAME_INTERVAL}, m_modes{std::move(modes)}, m_previewer{[this] { m_updates.Request(); }}
+    {
+        for (auto &mode : m_modes)
+        {
+            mode->Subscribe([this] { m_updates.Request(); });
+        }
+
         m_search.placeholder = L"Search";
         m_search.on_enter = std::bind(&Yaltl::Execute, this);
-        m_search.on_change = std::bind(&Yaltl::UpdateEntries, this);
+
+        // Searching waits for the next update, so a burst of typing or a paste is searched once
+        m_search.on_change = [this] {
+            m_modes[m_mode]->Search(m_search.content);
+            m_searchPending = true;
+            m_updates.Request();
+        };
 
         Add(&m_container);
         m_container.Add(&m_search);
-
-        m_results.selected_style = ftxui::bold | ftxui::color(ftxui::Color::Black) | ftxui::bgcolor(ftxui::Color::Green);
-        m_results.selected = 0;
-        m_container.Add(&m_results);
         UpdateEntries();
     }
 
     void Yaltl::Execute()
     {
-        if (!m_activeResults.empty())
+        // Enter may beat the search for what was just typed, or the sources still being ranked for it
+        FinishSearch();
+        if (m_selected < m_activeResults.size())
         {
-            auto &result{m_activeResults[m_results.selected]};
-            const PostExec postAction{m_modes[m_mode]->Execute(*result.result, m_search.content)};
-            switch (postAction)
+            auto &result{m_activeResults[m_selected]};
+            if (on_execute)
             {
-            case PostExec::StayOpen:
-                UpdateEntries();
+                on_execute(*result.result, m_search.content);
+            }
 
-                break;
-            case PostExec::CloseFailure:
-                on_exit(-1);
-                break;
-            case PostExec::CloseSuccess:
-                on_exit(0);
-                break;
+            Apply(result.owner->Execute(*result.result, m_search.content));
+        }
+    }
+
+    void Yaltl::FinishSearch()
+    {
+        if (m_searchPending)
+        {
+            UpdateEntries();
+        }
+
+        // Picking up what was ranked may find more entries loaded, which are ranked and waited for in turn
+        for (bool pending{true}; pending;)
+        {
+            for (std::unique_ptr<Ranking> &ranking : m_rankings)
+            {
+                if (ranking->search == m_searchGeneration)
+                {
+                    ranking->job.Wait();
+                }
             }
+
+            m_dirty = RefreshEntries() || m_dirty;
+            pending = std::any_of(std::begin(m_rankings), std::end(m_rankings), [this](const std::unique_ptr<Ranking> &ranking) { return ranking->search == m_searchGeneration; });
+        }
+    }
+
+    void Yaltl::Apply(PostExec postAction)
+    {
+        switch (postAction)
+        {
+        case PostExec::StayOpen:
+            UpdateEntries();
+
+            break;
+        case PostExec::CloseFailure:
+            on_exit(-1);
+            break;
+        case PostExec::CloseSuccess:
+            on_exit(0);
+            break;
         }
     }
 
@@ -60,17 +159,17 @@ namespace yaltl
         switch (move)
         {
         case Move::Up:
-            if (m_results.selected > 0)
+            if (m_selected > 0)
             {
-                --m_results.selected;
+                --m_selected;
             }
 
             break;
 
         case Move::Down:
-            if (m_results.selected < m_results.entries.size() - 1)
+            if (m_selected + 1 < m_activeResults.size())
             {
-                ++m_results.selected;
+                ++m_selected;
             }
 
             break;
@@ -79,6 +178,22 @@ namespace yaltl
 
     bool Yaltl::OnEvent(ftxui::Event event)
     {
+        // A mode has loaded more results in the background, a preview is ready, or the search changed
+        if (ftxui::Event::Custom == event)
+        {
+            const bool changed{m_searchPending ? (UpdateEntries(), true) : RefreshEntries()};
+            m_dirty = m_dirty || changed || m_previewPending || m_modes[m_mode]->Loading() != m_loading;
+            if (std::optional<PostExec> finished{m_modes[m_mode]->Finished()}; finished.has_value())
+            {
+                Apply(finished.value());
+            }
+
+            return true;
+        }
+
+        // Anything else may change what's shown
+        m_dirty = true;
+
         if (ftxui::Event::Escape == event)
         {
             if (on_exit)
@@ -115,93 +230,325 @@ namespace yaltl
         return ftxui::Component::OnEvent(event);
     }
 
-    std::wstring_view get_search(std::wstring &search, bool oneWord)
+    void Yaltl::UpdateEntries()
     {
-        if (!oneWord)
+        trace::Span span{"Yaltl::UpdateEntries"};
+        Mode &active{*m_modes[m_mode]};
+        std::vector<Mode *> parts{active.Parts()};
+        if (parts.empty())
         {
-            return search;
+            parts.push_back(&active);
         }
 
-        if (size_t pos{search.find(L' ')}; pos != std::wstring::npos)
+        m_sources.clear();
+        std::transform(std::begin(parts), std::end(parts), std::back_inserter(m_sources), [](Mode *mode) { return Source{mode}; });
+
+        // Rankings for the last search are skipped if they haven't started, the rest are dropped once done
+        ++m_searchGeneration;
+        for (std::unique_ptr<Ranking> &ranking : m_rankings)
         {
-            return std::wstring_view(search.c_str(), pos);
+            ranking->job.Cancel();
         }
 
-        return search;
+        // A new search starts from its best result
+        m_activeResults.clear();
+        m_exact = 0;
+        m_selected = 0;
+        m_top = 0;
+        SearchSources();
+        MergeRankings();
+        m_searchPending = false;
+        stats::matched(searched(m_sources), m_activeResults.size());
     }
 
-    void Yaltl::UpdateEntries()
+    void Yaltl::SearchSources()
     {
-        const Entries &results{m_modes[m_mode]->Results()};
-        m_activeResults.resize(results.size());
-        std::transform(std::begin(results), std::end(results), std::begin(m_activeResults), [](std::shared_ptr<Entry> ptr)
-                       { return FuzzyResult{ptr, std::nullopt}; });
-
-        std::wstring_view realSearch{get_search(m_search.content, m_modes[m_mode]->FirstWordOnly())};
-        if (!realSearch.empty())
+        for (Source &source : m_sources)
         {
-            regex::regex_t regex{regex::build_regex(realSearch)};
-            std::transform(std::begin(m_activeResults), std::end(m_activeResults), std::begin(m_activeResults), [&regex](const FuzzyResult &fuzzy)
-                           {
-                auto &criteria = fuzzy.result->criteria;
-                std::optional<std::wstring_view> fuzzFactor;
-                if (criteria.has_value())
+            const Entries &entries{source.mode->Results()};
+            const FrontCoded *store{source.mode->Store()};
+            const size_t from{source.searched};
+            source.searched = count(*source.mode);
+            source.generation = source.mode->Generation();
+            if (from == source.searched)
+            {
+                continue;
+            }
+
+            Ranking &ranking{*m_rankings.emplace_back(std::make_unique<Ranking>())};
+            ranking.search = m_searchGeneration;
+
+            // Combined modes are ranked side by side and each shown as it's done, so a big one doesn't hold up the rest
+            const bool background{m_sources.size() > 1};
+            if (background && !store)
+            {
+                ranking.entries.assign(std::begin(entries) + from, std::end(entries));
+            }
+
+            auto rank{[search = m_search.content, &entries = background ? ranking.entries : entries, first = background ? 0 : from, store, &ranking, from, mode{source.mode}, firstWordOnly{source.mode->FirstWordOnly()}] {
+                // Modes with an index only need the entries it found scored
+                std::optional<std::vector<uint32_t>> candidates{from == 0 ? mode->Candidates(matcher::search_text(search, firstWordOnly)) : std::nullopt};
+                if (store)
+                {
+                    // Compact stores are only searched whole, they're loaded before the mode is built
+                    ranking.results = matcher::rank(*store, candidates, search, firstWordOnly, STORE_RESULTS, ranking.exact);
+                }
+                else if (candidates.has_value())
                 {
-                    std::vector<std::optional<std::wstring_view>> fuzz;
-                    fuzz.reserve(criteria.value().size());
-                    std::transform(std::begin(criteria.value()), std::end(criteria.value()), std::back_inserter(fuzz), [&regex](const std::wstring &critter) {
-                        return regex::fuzzy_find(critter, regex);
-                    });
-
-                    fuzz.erase(std::remove(std::begin(fuzz), std::end(fuzz), std::nullopt), std::end(fuzz));
-                    if (!fuzz.empty())
-                    {
-                        fuzzFactor = fuzz[0];
-                    }
+                    Entries subset;
+                    subset.reserve(candidates->size());
+                    std::transform(std::begin(candidates.value()), std::end(candidates.value()), std::back_inserter(subset), [&entries](uint32_t index) { return entries[index]; });
+                    ranking.results = matcher::rank(std::begin(subset), std::end(subset), search, firstWordOnly, ranking.exact);
                 }
                 else
                 {
-                    fuzzFactor = regex::fuzzy_find(fuzzy.result->display, regex);
+                    ranking.results = matcher::rank(std::begin(entries) + first, std::end(entries), search, firstWordOnly, ranking.exact);
                 }
 
-                return FuzzyResult{fuzzy.result, fuzzFactor}; });
+                for (FuzzyResult &result : ranking.results)
+                {
+                    result.owner = mode;
+                }
+
+                ranking.done = true;
+            }};
+
+            if (!background)
+            {
+                rank();
+                continue;
+            }
+
+            ranking.job = executor::submit(executor::Lane::Interactive, [this, rank{std::move(rank)}](std::stop_token) {
+                rank();
+                m_updates.Request();
+            });
+        }
+    }
+
+    bool Yaltl::MergeRankings()
+    {
+        bool merged{};
+        std::erase_if(m_rankings, [this, &merged](const std::unique_ptr<Ranking> &ranking) {
+            if (ranking->search != m_searchGeneration)
+            {
+                return ranking->done || ranking->job.Done();
+            }
+
+            if (!ranking->done)
+            {
+                return false;
+            }
 
-            std::sort(std::begin(m_activeResults), std::end(m_activeResults));
+            merge(m_activeResults, m_exact, std::move(ranking->results), ranking->exact);
+            merged = true;
+            return true;
+        });
 
-            m_activeResults.erase(std::remove_if(std::begin(m_activeResults), std::end(m_activeResults), [](const FuzzyResult &fuzzy)
-                                                 { return !fuzzy.match.has_value(); }),
-                                  std::end(m_activeResults));
+        return merged;
+    }
 
-            std::stable_partition(std::begin(m_activeResults), std::end(m_activeResults), [&search{m_search.content}](const FuzzyResult &fuzzy)
-                                  { return mtl::string::ifind(fuzzy.result->display, search) != std::wstring::npos; });
+    bool Yaltl::RefreshEntries()
+    {
+        bool replaced{};
+        bool appended{};
+        for (const Source &source : m_sources)
+        {
+            const size_t results{count(*source.mode)};
+            replaced = replaced || results < source.searched || source.mode->Generation() != source.generation;
+            appended = appended || results > source.searched;
         }
+
+        const bool ranked{std::any_of(std::begin(m_rankings), std::end(m_rankings), [this](const std::unique_ptr<Ranking> &ranking) { return ranking->search == m_searchGeneration && ranking->done; })};
+        if (!replaced && !appended && !ranked)
+        {
+            return false;
+        }
+
+        trace::Span span{"Yaltl::RefreshEntries"};
+
+        // Keep a selection that was moved on the same entry while results stream in, otherwise the best result stays selected
+        std::shared_ptr<Entry> selected;
+        if (m_selected > 0 && m_selected < m_activeResults.size())
+        {
+            selected = m_activeResults[m_selected].result;
+        }
+
+        if (replaced)
+        {
+            // Results were replaced or removed, nothing to build on
+            UpdateEntries();
+        }
+        else
+        {
+            SearchSources();
+            MergeRankings();
+        }
+
+        if (selected)
+        {
+            auto itr{std::find_if(std::begin(m_activeResults), std::end(m_activeResults), [&selected](const FuzzyResult &fuzzy)
+                                  { return fuzzy.result == selected; })};
+
+            // Replaced results are new entries, so look for the same text
+            if (itr == std::end(m_activeResults))
+            {
+                itr = std::find_if(std::begin(m_activeResults), std::end(m_activeResults), [&selected](const FuzzyResult &fuzzy)
+                                   { return fuzzy.result->display == selected->display; });
+            }
+
+            if (itr != std::end(m_activeResults))
+            {
+                m_selected = std::distance(std::begin(m_activeResults), itr);
+            }
+        }
+
+        stats::matched(searched(m_sources), m_activeResults.size());
+        return true;
     }
 
     ftxui::Element Yaltl::Render()
     {
-        m_results.entries.resize(m_activeResults.size());
-        std::transform(std::begin(m_activeResults), std::end(m_activeResults), std::begin(m_results.entries), [](const FuzzyResult &result)
-                       { return result.result->display; });
+        // The last frame has been written out by now
+        stats::frame();
+
+        // Nothing changed since the last frame, so it can be drawn again as is
+        if (!m_dirty && m_frame && !terminal::resized())
+        {
+            return m_frame;
+        }
+
+        trace::Span span{m_frame ? "Yaltl::Render" : "Yaltl::Render first frame"};
+        stats::Timer timer{stats::Stage::Render};
+        m_dirty = false;
+        if (m_selected >= m_activeResults.size())
+        {
+            m_selected = m_activeResults.empty() ? 0 : m_activeResults.size() - 1;
+        }
+
+        const ftxui::Terminal::Dimensions size{terminal::size()};
+
+        ftxui::Elements prompt{ftxui::text(m_modes[m_mode]->Name() + L": "), m_search.Render()};
+        m_loading = m_modes[m_mode]->Loading();
+        if (m_loading)
+        {
+            prompt.push_back(ftxui::text(L" loading...") | ftxui::dim);
+        }
+
+        ftxui::Elements lines{ftxui::hbox(std::move(prompt))};
+        if (stats::enabled())
+        {
+            lines.push_back(ftxui::text(stats::status()) | ftxui::dim);
+        }
+
+        // Everything but the lines above and the line ftxui leaves for the cursor
+        const int header{static_cast<int>(lines.size())};
+        ftxui::Element results{RenderResults(static_cast<size_t>(std::max(size.dimy - header - 1, 1)))};
+        if (m_modes[m_mode]->HasPreview())
+        {
+            results = ftxui::hbox({results | ftxui::flex,
+                                   ftxui::separator(),
+                                   RenderPreview() | ftxui::frame | ftxui::size(ftxui::WIDTH, ftxui::EQUAL, size.dimx / 2)});
+        }
+
+        lines.push_back(results | ftxui::size(ftxui::HEIGHT, ftxui::LESS_THAN, size.dimy - header));
+        const bool first{!m_frame};
+        m_frame = ftxui::vbox(std::move(lines));
+        if (first && on_first_frame)
+        {
+            std::exchange(on_first_frame, nullptr)();
+        }
+
+        return m_frame;
+    }
+
+    ftxui::Element Yaltl::RenderResults(size_t rows)
+    {
+        // Scroll only as far as it takes to show the selection
+        if (m_selected < m_top)
+        {
+            m_top = m_selected;
+        }
+        else if (m_selected >= m_top + rows)
+        {
+            m_top = m_selected - rows + 1;
+        }
+
+        m_top = std::min(m_top, m_activeResults.size() > rows ? m_activeResults.size() - rows : 0);
 
-        if (m_results.selected >= m_results.entries.size())
+        if (m_search.content != m_highlighted)
         {
-            m_results.selected = m_results.entries.size() - 1;
+            m_highlights.clear();
+            m_highlighted = m_search.content;
         }
 
-        if (m_results.selected < 0)
+        // Only rows that are still shown stay cached
+        std::unordered_map<std::shared_ptr<Entry>, std::vector<size_t>> highlights;
+        const size_t bottom{std::min(m_top + rows, m_activeResults.size())};
+        ftxui::Elements lines;
+        lines.reserve(bottom - m_top);
+        for (size_t row{m_top}; row < bottom; ++row)
         {
-            m_results.selected = 0;
+            const std::shared_ptr<Entry> &entry{m_activeResults[row].result};
+            Mode &owner{*m_activeResults[row].owner};
+            auto itr{m_highlights.find(entry)};
+            std::vector<size_t> positions{itr != std::end(m_highlights) ? std::move(itr->second)
+                                                                        : regex::match_positions(entry->display, matcher::search_text(m_search.content, owner.FirstWordOnly()))};
+
+            // Splits the text into runs that did and didn't match
+            const bool selected{row == m_selected};
+            const std::wstring_view display{entry->display};
+            ftxui::Elements parts{ftxui::text(selected ? L"> " : L"  ")};
+            size_t done{};
+            for (auto pos{std::begin(positions)}; pos != std::end(positions);)
+            {
+                auto runEnd{std::adjacent_find(pos, std::end(positions), [](size_t lhs, size_t rhs)
+                                               { return rhs != lhs + 1; })};
+                runEnd = runEnd == std::end(positions) ? runEnd : std::next(runEnd);
+
+                parts.push_back(ftxui::text(std::wstring{display.substr(done, *pos - done)}));
+                done = *std::prev(runEnd) + 1;
+                parts.push_back(ftxui::text(std::wstring{display.substr(*pos, done - *pos)}) |
+                                (selected ? ftxui::underlined : ftxui::color(ftxui::Color::Green)));
+                pos = runEnd;
+            }
+
+            parts.push_back(ftxui::text(std::wstring{display.substr(done)}));
+
+            // Combined results are tagged with where they came from
+            if (m_sources.size() > 1)
+            {
+                parts.push_back(ftxui::filler());
+                parts.push_back(ftxui::text(owner.Name() + L" ") | ftxui::dim);
+            }
+
+            ftxui::Element line{ftxui::hbox(std::move(parts))};
+            lines.push_back(selected ? line | ftxui::bold | ftxui::color(ftxui::Color::Black) | ftxui::bgcolor(ftxui::Color::Green) : line);
+            highlights.emplace(entry, std::move(positions));
         }
 
-        if (!m_activeResults.empty())
+        m_highlights = std::move(highlights);
+
+        return ftxui::vbox(std::move(lines));
+    }
+
+    ftxui::Element Yaltl::RenderPreview()
+    {
+        m_previewPending = false;
+        if (m_activeResults.empty())
         {
-            auto &res{m_activeResults[m_results.selected]};
-            m_modes[m_mode]->Preview(*res.result);
+            return ftxui::text(L"");
         }
 
-        ftxui::Terminal::Dimensions size{ftxui::Terminal::Size()};
+        // Never waits on the mode, the preview shows up on a later frame once it's built
+        const FuzzyResult &selected{m_activeResults[m_selected]};
+        std::optional<ftxui::Element> preview{m_previewer.Get(*selected.owner, selected.result)};
+        m_previewPending = !preview.has_value();
+        if (!preview.has_value())
+        {
+            return ftxui::text(L"...") | ftxui::dim;
+        }
 
-        return ftxui::vbox({ftxui::hbox({ftxui::text(m_modes[m_mode]->Name() + L": "), m_search.Render()}),
-                            m_results.Render() | ftxui::yframe | ftxui::size(ftxui::HEIGHT, ftxui::LESS_THAN, size.dimy - 1)});
+        return preview.value() ? preview.value() : ftxui::text(L"");
     }
 } // namespace yaltl
@@ -0,0 +1,192 @@
+#include "check.h"
+#include "utils/charindex.h"
+#include "utils/frontcoded.h"
+#include "utils/regex.h"
+
+#include <algorithm>
+#include <clocale>
+#include <codecvt>
+#include <locale>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Checks that CharIndex::Candidates never leaves out an entry the search's regex matches.
+ *
+ * Entries and searches are random mixes of both cases, digits, punctuation and characters the regex backends
+ * may fold differently than the index, i.e: the Kelvin sign and the long s, under the C locale and a UTF-8 one.
+ *
+ */
+namespace tests
+{
+    using yaltl::CharIndex;
+    using yaltl::Entries;
+    using yaltl::Entry;
+    using yaltl::FrontCoded;
+
+    //! Entries indexed per run, short ones so most postings aren't dense and get intersected
+    constexpr size_t ENTRIES{20'000};
+
+    //! Searches checked per run
+    constexpr size_t SEARCHES{200};
+
+    //! Enough that the index is always built
+    constexpr size_t BUDGET{64 << 20};
+
+    //! What entries and searches are made of, weighted towards what's indexed
+    constexpr std::wstring_view ALPHABET{L"abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789"
+                                         L"abcdefghijklmnopqrstuvwxyz0123456789 ._-/"
+                                         L"éÉßKſİıÿŸΣσж日"};
+
+    std::wstring random_text(std::mt19937 &random, size_t shortest, size_t longest)
+    {
+        std::uniform_int_distribution<size_t> length{shortest, longest};
+        std::uniform_int_distribution<size_t> pick{0, ALPHABET.size() - 1};
+        std::wstring text(length(random), L' ');
+        std::generate(std::begin(text), std::end(text), [&] { return ALPHABET[pick(random)]; });
+
+        return text;
+    }
+
+    //! Some entries have criteria instead, any of which may match
+    Entries random_entries(std::mt19937 &random)
+    {
+        Entries entries;
+        entries.reserve(ENTRIES);
+        for (size_t x{}; x < ENTRIES; ++x)
+        {
+            entries.push_back(std::make_shared<Entry>(random_text(random, 2, 10)));
+            if (x % 4 == 0)
+            {
+                entries.back()->criteria = std::vector<std::wstring>{random_text(random, 2, 10), random_text(random, 2, 10)};
+            }
+        }
+
+        return entries;
+    }
+
+    bool matches(const Entry &entry, const yaltl::regex::regex_t &regex)
+    {
+        if (!entry.criteria.has_value())
+        {
+            return yaltl::regex::fuzzy_find(entry.display, regex).has_value();
+        }
+
+        return std::any_of(std::begin(entry.criteria.value()), std::end(entry.criteria.value()), [&regex](const std::wstring &criteria) {
+            return yaltl::regex::fuzzy_find(criteria, regex).has_value();
+        });
+    }
+
+    /**
+     * @brief Checks the candidates of random searches against the regex
+     *
+     * @param index The index of the entries
+     * @param entries The entries, as the regex sees them
+     * @param random Where the searches come from
+     * @return size_t How many searches were narrowed down, so the check isn't passing by never narrowing anything
+     */
+    size_t superset(const CharIndex &index, const Entries &entries, std::mt19937 &random)
+    {
+        size_t narrowed{};
+        for (size_t x{}; x < SEARCHES; ++x)
+        {
+            const std::wstring search{random_text(random, 1, 4)};
+            const std::optional<std::vector<uint32_t>> candidates{index.Candidates(search)};
+            if (!candidates.has_value())
+            {
+                continue;
+            }
+
+            CHECK(std::is_sorted(std::begin(candidates.value()), std::end(candidates.value())));
+            CHECK(std::adjacent_find(std::begin(candidates.value()), std::end(candidates.value())) == std::end(candidates.value()));
+            narrowed += candidates->size() < entries.size();
+
+            // Only what was left out needs the regex
+            const yaltl::regex::regex_t regex{yaltl::regex::build_regex(search)};
+            auto candidate{std::begin(candidates.value())};
+            for (uint32_t entry{}; entry < entries.size(); ++entry)
+            {
+                if (candidate != std::end(candidates.value()) && *candidate == entry)
+                {
+                    ++candidate;
+                    continue;
+                }
+
+                if (matches(*entries[entry], regex))
+                {
+                    std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+                    std::cerr << "\"" << converter.to_bytes(search) << "\" matches \"" << converter.to_bytes(entries[entry]->display) << "\" which isn't a candidate" << std::endl;
+                    CHECK(!"a match was left out");
+                    return narrowed;
+                }
+            }
+        }
+
+        return narrowed;
+    }
+
+    void entries(std::mt19937 &random)
+    {
+        const Entries entries{random_entries(random)};
+        const std::optional<CharIndex> index{CharIndex::build(entries, BUDGET, std::stop_token{})};
+        CHECK(index.has_value());
+        if (index.has_value())
+        {
+            CHECK(index->Size() == entries.size());
+            CHECK(superset(index.value(), entries, random) > 0);
+        }
+    }
+
+    //! Compact stores are indexed by the lines alone
+    void store(std::mt19937 &random)
+    {
+        std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+        Entries entries;
+        FrontCoded lines;
+        for (size_t x{}; x < ENTRIES; ++x)
+        {
+            entries.push_back(std::make_shared<Entry>(random_text(random, 2, 10)));
+            lines.Append(converter.to_bytes(entries.back()->display));
+        }
+
+        const std::optional<CharIndex> index{CharIndex::build(lines, BUDGET, std::stop_token{})};
+        CHECK(index.has_value());
+        if (index.has_value())
+        {
+            CHECK(index->Size() == lines.Size());
+            CHECK(superset(index.value(), entries, random) > 0);
+        }
+    }
+
+    //! The index should give up instead of going over its budget
+    void budget(std::mt19937 &random)
+    {
+        CHECK(!CharIndex::build(random_entries(random), 1024, std::stop_token{}).has_value());
+    }
+} // namespace tests
+
+int main()
+{
+    // Runs seeded the same fail the same
+    std::mt19937 random{20'240'601};
+    tests::entries(random);
+    tests::store(random);
+    tests::budget(random);
+
+    // Case folding beyond ASCII only happens under a locale that has it
+    try
+    {
+        std::locale::global(std::locale{"C.UTF-8"});
+        std::setlocale(LC_ALL, "C.UTF-8");
+        tests::entries(random);
+        tests::store(random);
+    }
+    catch (const std::runtime_error &)
+    {
+        std::cout << "C.UTF-8 isn't available, only checked the C locale" << std::endl;
+    }
+
+    return tests::finish();
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <iostream>
+
+/**
+ * @brief What every yaltl test shares, failed checks are printed and counted rather than stopping the test.
+ *
+ */
+namespace tests
+{
+    inline int g_failures{};
+
+    inline void check(bool passed, const char *condition, const char *file, int line)
+    {
+        if (!passed)
+        {
+            std::cerr << file << ":" << line << ": failed: " << condition << std::endl;
+            ++g_failures;
+        }
+    }
+
+#define CHECK(condition) tests::check((condition), #condition, __FILE__, __LINE__)
+
+    //! Says how the checks went, returned from main
+    inline int finish()
+    {
+        if (g_failures > 0)
+        {
+            std::cerr << g_failures << " checks failed" << std::endl;
+            return 1;
+        }
+
+        std::cout << "all checks passed" << std::endl;
+        return 0;
+    }
+} // namespace tests
@@ -0,0 +1,160 @@
+#include "check.h"
+#include "utils/frontcoded.h"
+#include "utils/utf8.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Checks that lines come back out of a FrontCoded store the same as they went in.
+ *
+ * The lines are random paths sharing prefixes of every length, with empty lines, lines long enough for
+ * multi-byte lengths, non-ASCII and bytes that aren't UTF-8, which come back the same as utf8::widen gives them.
+ *
+ */
+namespace tests
+{
+    using yaltl::FrontCoded;
+
+    //! Not a multiple of the block size, so the last block is partial
+    constexpr size_t LINES{10'007};
+
+    //! Random ranges and subsets read back
+    constexpr size_t READS{200};
+
+    std::vector<std::string> random_lines(std::mt19937 &random)
+    {
+        const std::vector<std::string> parts{"usr", "lib", "share", "", "é", "日本語", "\xff\xfe", "\xe6\x97", "a b", std::string(300, 'x')};
+        std::uniform_int_distribution<size_t> pick{0, parts.size() - 1};
+        std::uniform_int_distribution<size_t> depth{0, 6};
+        std::uniform_int_distribution<size_t> keep{0, 100};
+
+        std::vector<std::string> lines;
+        lines.reserve(LINES);
+        std::string line;
+        for (size_t x{}; x < LINES; ++x)
+        {
+            // Keep some of the line before so consecutive lines share prefixes, sometimes all of it
+            line.resize(std::min(line.size(), line.size() * keep(random) / 100));
+            for (size_t level{depth(random)}; level > 0; --level)
+            {
+                line += "/" + parts[pick(random)];
+            }
+
+            lines.push_back(line);
+        }
+
+        return lines;
+    }
+
+    //! Reads every line back in order, in one go and in random ranges
+    void scan(const FrontCoded &store, const std::vector<std::wstring> &expected, std::mt19937 &random)
+    {
+        size_t next{};
+        store.Scan(0, store.Size(), [&](size_t index, std::wstring_view line) {
+            CHECK(index == next);
+            CHECK(line == expected[index]);
+            ++next;
+            return true;
+        });
+        CHECK(next == expected.size());
+
+        // Ranges may start mid block and run past the end
+        std::uniform_int_distribution<size_t> from{0, expected.size()};
+        std::uniform_int_distribution<size_t> length{0, 3 * FrontCoded::BLOCK_LINES};
+        for (size_t x{}; x < READS; ++x)
+        {
+            const size_t begin{from(random)};
+            const size_t end{begin + length(random)};
+            size_t visited{};
+            store.Scan(begin, end, [&](size_t index, std::wstring_view line) {
+                CHECK(index == begin + visited);
+                CHECK(line == expected[index]);
+                ++visited;
+                return true;
+            });
+            CHECK(visited == std::min(end, expected.size()) - begin);
+        }
+
+        // Returning false stops the scan
+        size_t visited{};
+        store.Scan(0, store.Size(), [&visited](size_t, std::wstring_view) { return ++visited < 3; });
+        CHECK(visited == 3);
+    }
+
+    //! Reads back random subsets, in order with repeats, the way candidates are looked at
+    void lines(const FrontCoded &store, const std::vector<std::wstring> &expected, std::mt19937 &random)
+    {
+        std::uniform_int_distribution<uint32_t> pick{0, static_cast<uint32_t>(expected.size() - 1)};
+        std::uniform_int_distribution<size_t> count{1, 64};
+        for (size_t x{}; x < READS; ++x)
+        {
+            std::vector<uint32_t> indexes(count(random));
+            std::generate(std::begin(indexes), std::end(indexes), [&] { return pick(random); });
+            std::sort(std::begin(indexes), std::end(indexes));
+
+            size_t visited{};
+            store.Lines(indexes, [&](size_t index, std::wstring_view line) {
+                CHECK(index == indexes[visited]);
+                CHECK(line == expected[index]);
+                ++visited;
+                return true;
+            });
+            CHECK(visited == indexes.size());
+        }
+
+        // Indexes past the end stop the lookup there
+        const std::vector<uint32_t> past{0, static_cast<uint32_t>(expected.size()), 1};
+        size_t visited{};
+        store.Lines(past, [&visited](size_t, std::wstring_view) { return ++visited > 0; });
+        CHECK(visited == 1);
+    }
+
+    void round_trip(std::mt19937 &random)
+    {
+        const std::vector<std::string> raw{random_lines(random)};
+        std::vector<std::wstring> expected;
+        expected.reserve(raw.size());
+        FrontCoded store;
+        for (const std::string &line : raw)
+        {
+            store.Append(line);
+            expected.push_back(yaltl::utf8::widen(line));
+        }
+
+        CHECK(store.Size() == raw.size());
+        scan(store, expected, random);
+        lines(store, expected, random);
+
+        // Giving back what was reserved doesn't change the lines
+        store.Shrink();
+        CHECK(store.Bytes() > 0);
+        scan(store, expected, random);
+        lines(store, expected, random);
+    }
+
+    void empty()
+    {
+        FrontCoded store;
+        store.Shrink();
+        CHECK(store.Size() == 0);
+
+        size_t visited{};
+        store.Scan(0, 10, [&visited](size_t, std::wstring_view) { return ++visited > 0; });
+        const std::vector<uint32_t> indexes{0};
+        store.Lines(indexes, [&visited](size_t, std::wstring_view) { return ++visited > 0; });
+        CHECK(visited == 0);
+    }
+} // namespace tests
+
+int main()
+{
+    // Runs seeded the same fail the same
+    std::mt19937 random{20'240'602};
+    tests::round_trip(random);
+    tests::empty();
+
+    return tests::finish();
+}
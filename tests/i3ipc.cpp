@@ -0,0 +1,445 @@
+#include "check.h"
+#include "modes/i3wm.h"
+#include "utils/i3ipc.h"
+#include "utils/json.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <codecvt>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <locale>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * @brief Checks the i3 IPC client and the tree parsing against recorded i3 and sway replies.
+ *
+ * The replies are served over a unix socket by FakeI3, which $I3SOCK points the client at,
+ * so the whole path from the socket to the listed windows runs the same as under a real compositor.
+ *
+ */
+namespace tests
+{
+    using Window = yaltl::modes::i3wm::Window;
+
+    //! How often the fake server checks if it should stop
+    constexpr int POLL_MS{20};
+
+    //! How long to wait on the mode to pick up events before failing
+    constexpr std::chrono::seconds EVENT_TIMEOUT{5};
+
+    //! Reads a recorded reply from tests/data
+    std::string fixture(const std::string &name)
+    {
+        std::ifstream in{std::filesystem::path{YALTL_TEST_DATA} / name, std::ios::binary};
+        return std::string{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+    }
+
+    void expect_windows(const std::vector<Window> &actual, const std::vector<Window> &expected)
+    {
+        CHECK(actual.size() == expected.size());
+        for (size_t x{}; x < std::min(actual.size(), expected.size()); ++x)
+        {
+            const bool same{actual[x].id == expected[x].id && actual[x].name == expected[x].name && actual[x].app_id == expected[x].app_id};
+            if (!same)
+            {
+                std::cerr << "window " << x << ": got {" << actual[x].id << ", " << actual[x].name << ", " << actual[x].app_id << "} expected {"
+                          << expected[x].id << ", " << expected[x].name << ", " << expected[x].app_id << "}" << std::endl;
+            }
+
+            CHECK(same);
+        }
+    }
+
+    bool write_all(int fd, std::string_view data)
+    {
+        while (!data.empty())
+        {
+            const ssize_t written{write(fd, data.data(), data.size())};
+            if (written < 0 && errno == EINTR)
+            {
+                continue;
+            }
+
+            if (written <= 0)
+            {
+                return false;
+            }
+
+            data.remove_prefix(written);
+        }
+
+        return true;
+    }
+
+    bool read_all(int fd, char *data, size_t size)
+    {
+        while (size > 0)
+        {
+            const ssize_t count{read(fd, data, size)};
+            if (count < 0 && errno == EINTR)
+            {
+                continue;
+            }
+
+            if (count <= 0)
+            {
+                return false;
+            }
+
+            data += count;
+            size -= count;
+        }
+
+        return true;
+    }
+
+    //! Frames a message the way i3 does, magic then the payload size and type in native byte order
+    std::string frame(uint32_t type, std::string_view payload)
+    {
+        std::string message{"i3-ipc"};
+        const uint32_t header[]{static_cast<uint32_t>(payload.size()), type};
+        message.append(reinterpret_cast<const char *>(header), sizeof(header));
+        message.append(payload);
+
+        return message;
+    }
+
+    /**
+     * @brief Plays i3 on a unix socket, answering GET_TREE with a recorded tree and sending recorded events to subscribers
+     *
+     */
+    class FakeI3
+    {
+    public:
+        /**
+         * @brief Starts listening, pointing $I3SOCK at the socket
+         *
+         * @param tree The GET_TREE reply
+         * @param events Event type and payload pairs, sent to subscribers once the tree was served so none are missed
+         */
+        FakeI3(std::string tree, std::vector<std::pair<yaltl::i3::Event, std::string>> events = {}) : m_tree(std::move(tree)), m_events(std::move(events))
+        {
+            m_path = (std::filesystem::temp_directory_path() / ("yaltl_tests." + std::to_string(getpid()) + ".sock")).string();
+            std::filesystem::remove(m_path);
+
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            std::memcpy(address.sun_path, m_path.c_str(), std::min(m_path.size(), sizeof(address.sun_path) - 1));
+
+            m_listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if (m_listener < 0 || 0 != bind(m_listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) || 0 != listen(m_listener, 8))
+            {
+                std::cerr << "can't listen on " << m_path << ": " << std::strerror(errno) << std::endl;
+                std::exit(2);
+            }
+
+            setenv("I3SOCK", m_path.c_str(), 1);
+            unsetenv("SWAYSOCK");
+            m_accepting = std::jthread{[this](std::stop_token stop) { Accept(stop); }};
+        }
+
+        ~FakeI3()
+        {
+            m_accepting.request_stop();
+            m_accepting.join();
+
+            // Stopped outside the lock, connections take it on their way out
+            std::vector<std::jthread> connections;
+            {
+                std::scoped_lock lock{m_lock};
+                connections.swap(m_connections);
+            }
+
+            connections.clear();
+
+            close(m_listener);
+            std::filesystem::remove(m_path);
+        }
+
+        //! Replies to RUN_COMMAND with this instead of success
+        void FailCommands(std::string reply)
+        {
+            std::scoped_lock lock{m_lock};
+            m_commandReply = std::move(reply);
+        }
+
+        //! The commands that were run so far
+        std::vector<std::string> Commands()
+        {
+            std::scoped_lock lock{m_lock};
+            return m_commands;
+        }
+
+    private:
+        void Accept(std::stop_token stop)
+        {
+            pollfd fd{m_listener, POLLIN, 0};
+            while (!stop.stop_requested())
+            {
+                if (poll(&fd, 1, POLL_MS) <= 0)
+                {
+                    continue;
+                }
+
+                if (const int client{accept4(m_listener, nullptr, nullptr, SOCK_CLOEXEC)}; client >= 0)
+                {
+                    std::scoped_lock lock{m_lock};
+                    m_connections.emplace_back([this, client](std::stop_token stop) { Serve(client, stop); });
+                }
+            }
+        }
+
+        void Serve(int client, std::stop_token stop)
+        {
+            pollfd fd{client, POLLIN, 0};
+            while (!stop.stop_requested())
+            {
+                if (poll(&fd, 1, POLL_MS) <= 0)
+                {
+                    continue;
+                }
+
+                char header[6 + 2 * sizeof(uint32_t)]{};
+                if (!read_all(client, header, sizeof(header)) || std::string_view{header, 6} != "i3-ipc")
+                {
+                    break;
+                }
+
+                uint32_t size{};
+                uint32_t type{};
+                std::memcpy(&size, header + 6, sizeof(size));
+                std::memcpy(&type, header + 6 + sizeof(size), sizeof(type));
+
+                std::string payload(size, '\0');
+                if (!read_all(client, payload.data(), size) || !Reply(client, static_cast<yaltl::i3::Message>(type), payload, stop))
+                {
+                    break;
+                }
+            }
+
+            close(client);
+        }
+
+        bool Reply(int client, yaltl::i3::Message type, const std::string &payload, std::stop_token stop)
+        {
+            switch (type)
+            {
+            case yaltl::i3::Message::GetTree:
+            {
+                if (!write_all(client, frame(static_cast<uint32_t>(type), m_tree)))
+                {
+                    return false;
+                }
+
+                {
+                    std::scoped_lock lock{m_lock};
+                    m_treeServed = true;
+                }
+
+                m_served.notify_all();
+                return true;
+            }
+            case yaltl::i3::Message::Subscribe:
+            {
+                if (!write_all(client, frame(static_cast<uint32_t>(type), R"({"success":true})")))
+                {
+                    return false;
+                }
+
+                std::unique_lock lock{m_lock};
+                if (!m_served.wait(lock, stop, [this] { return m_treeServed; }))
+                {
+                    return false;
+                }
+
+                lock.unlock();
+                return std::all_of(std::begin(m_events), std::end(m_events), [client](const auto &event) {
+                    return write_all(client, frame(static_cast<uint32_t>(event.first), event.second));
+                });
+            }
+            case yaltl::i3::Message::RunCommand:
+            {
+                std::string reply;
+                {
+                    std::scoped_lock lock{m_lock};
+                    m_commands.push_back(payload);
+                    reply = m_commandReply;
+                }
+
+                return write_all(client, frame(static_cast<uint32_t>(type), reply));
+            }
+            default:
+                return write_all(client, frame(static_cast<uint32_t>(type), "[]"));
+            }
+        }
+
+    private:
+        const std::string m_tree;
+        const std::vector<std::pair<yaltl::i3::Event, std::string>> m_events;
+        std::string m_path;
+        int m_listener{-1};
+
+        std::mutex m_lock;
+        std::condition_variable_any m_served;
+        bool m_treeServed{};
+        std::string m_commandReply{R"([{"success":true}])"};
+        std::vector<std::string> m_commands;
+        std::vector<std::jthread> m_connections;
+
+        //! Declared last so nothing is accepted once the rest is gone
+        std::jthread m_accepting;
+    };
+
+    const std::vector<Window> I3_WINDOWS{
+        {94470403519200, "Notes \u2014 scratchpad", "gedit"},
+        {94470403489760, "Release notes \"4.23\" - Mozilla Firefox", "Navigator"},
+        {94470403497952, "C:\\Users\\me \u2502 vim", "Alacritty"},
+        {94470403510240, "Volume Control \U0001F50A", "pavucontrol"},
+    };
+
+    const std::vector<Window> SWAY_WINDOWS{
+        {6, "~/src/yaltl \u2014 \"fish\"", "foot"},
+        {9, "Caf\u00e9 men\u00fa / tab\tone - Mozilla Firefox", "Navigator"},
+        {11, "htop", "foot"},
+        {12, "\u65e5\u672c\u8a9e \U0001F680 notes", "org.gnome.TextEditor"},
+        {13, "Volume Control", "org.pulseaudio.pavucontrol"},
+    };
+
+    void scanner()
+    {
+        yaltl::json::Scanner scanner{R"( {"name": "q\"b\\s\/\n\u00e9\ud83d\ude80", "skip": [1, -2.5e3, {"x": [[], "]}"]}], "on": true, "gone": null, "id": 42} )"};
+        std::string name;
+        bool on{};
+        bool gone{};
+        uint64_t id{};
+        const bool parsed{scanner.Object([&](std::string_view key) {
+            if (key == "name")
+            {
+                return scanner.String(name);
+            }
+
+            if (key == "on")
+            {
+                return scanner.Bool(on);
+            }
+
+            if (key == "gone")
+            {
+                return gone = scanner.Null();
+            }
+
+            if (key == "id")
+            {
+                return scanner.Number(id);
+            }
+
+            return scanner.Skip();
+        })};
+
+        CHECK(parsed);
+        CHECK(name == "q\"b\\s/\n\u00e9\U0001F680");
+        CHECK(on);
+        CHECK(gone);
+        CHECK(id == 42);
+
+        // Truncated replies fail instead of reading past the end
+        std::string truncated;
+        yaltl::json::Scanner unterminated{R"({"name": "never closed)"};
+        CHECK(!unterminated.Object([&](std::string_view) { return unterminated.String(truncated); }));
+    }
+
+    void trees()
+    {
+        expect_windows(yaltl::modes::tree::windows(fixture("i3_tree.json"), "yaltl"), I3_WINDOWS);
+        expect_windows(yaltl::modes::tree::windows(fixture("sway_tree.json"), "yaltl"), SWAY_WINDOWS);
+
+        std::string change;
+        Window con;
+        bool isWindow{};
+        CHECK(yaltl::modes::tree::window_event(R"({"change":"title","container":{"id":11,"type":"con","name":"top \"-d\" 1","app_id":"foot","nodes":[],"floating_nodes":[]}})", "yaltl", change, con, isWindow));
+        CHECK(change == "title");
+        CHECK(isWindow);
+        expect_windows({con}, {{11, "top \"-d\" 1", "foot"}});
+
+        // Containers holding windows aren't windows themselves
+        CHECK(yaltl::modes::tree::window_event(R"({"change":"new","container":{"id":30,"type":"con","name":null,"app_id":null,"nodes":[{"id":31,"type":"con","name":"a","app_id":"b","nodes":[]}]}})", "yaltl", change, con, isWindow));
+        CHECK(!isWindow);
+    }
+
+    void connection()
+    {
+        const std::string tree{fixture("sway_tree.json")};
+        FakeI3 i3{tree};
+
+        yaltl::i3::Connection conn;
+        CHECK(conn.Connected());
+        CHECK(conn.Request(yaltl::i3::Message::GetTree) == tree);
+        CHECK(conn.Command("[con_id=9] focus"));
+        CHECK(i3.Commands() == std::vector<std::string>{"[con_id=9] focus"});
+
+        i3.FailCommands(R"([{"success":true},{"success":false,"parse_error":true,"error":"Unknown \"command\""}])");
+        CHECK(!conn.Command("[con_id=9] focus; nonsense"));
+    }
+
+    void mode()
+    {
+        using yaltl::i3::Event;
+        FakeI3 i3{fixture("sway_tree.json"),
+                  {
+                      {Event::Window, R"({"change":"new","container":{"id":20,"type":"con","name":"video \"1\".mkv","app_id":"mpv","nodes":[],"floating_nodes":[]}})"},
+                      {Event::Window, R"({"change":"new","container":{"id":21,"type":"con","name":"yaltl","app_id":"yaltl","nodes":[],"floating_nodes":[]}})"},
+                      {Event::Window, R"({"change":"title","container":{"id":11,"type":"con","name":"top","app_id":"foot","nodes":[],"floating_nodes":[]}})"},
+                      {Event::Window, R"({"change":"focus","container":{"id":6,"type":"con","name":"ignored","app_id":"foot","nodes":[],"floating_nodes":[]}})"},
+                      {Event::Window, R"({"change":"close","container":{"id":13,"type":"floating_con","name":"Volume Control","app_id":"org.pulseaudio.pavucontrol","nodes":[],"floating_nodes":[]}})"},
+                      {Event::Workspace, R"({"change":"focus","current":{"id":4,"name":"1"}})"},
+                  }};
+
+        // Compared as UTF-8, the way they were sent
+        const std::vector<std::string> expected{"~/src/yaltl \u2014 \"fish\"", "Caf\u00e9 men\u00fa / tab\tone - Mozilla Firefox", "top", "\u65e5\u672c\u8a9e \U0001F680 notes", "video \"1\".mkv"};
+        std::vector<std::string> listed;
+        std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+        yaltl::modes::i3wm windows{"yaltl"};
+        for (const auto deadline{std::chrono::steady_clock::now() + EVENT_TIMEOUT}; listed != expected && std::chrono::steady_clock::now() < deadline;)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds{POLL_MS});
+
+            const yaltl::Entries &entries{windows.Results()};
+            listed.clear();
+            std::transform(std::begin(entries), std::end(entries), std::back_inserter(listed), [&converter](const auto &entry) { return converter.to_bytes(entry->display); });
+        }
+
+        CHECK(listed == expected);
+
+        const yaltl::Entries &entries{windows.Results()};
+        if (entries.size() == expected.size())
+        {
+            CHECK(windows.Execute(*entries[1], L"") == yaltl::PostExec::CloseSuccess);
+            CHECK(i3.Commands() == std::vector<std::string>{"[con_id=9] focus"});
+        }
+    }
+} // namespace tests
+
+int main()
+{
+    tests::scanner();
+    tests::trees();
+    tests::connection();
+    tests::mode();
+
+    return tests::finish();
+}